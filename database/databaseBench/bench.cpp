@@ -0,0 +1,174 @@
+#include "sqlite3.h"
+#include "../src/bannerSql.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <functional>
+
+// ---------------------------------------------------------------------
+// SQLITE BENCHMARK
+// Same schema, statements and pragmas as SQLDatabase, run against whatever sqlite the executable is linked with.
+// databaseBench uses our build of the amalgamation, databaseBenchSystem the system library, run both and compare.
+// Second argument "clustered" runs it on the WITHOUT ROWID layout (wishTableLayout::Clustered).
+// Example usecase:		databaseBench 200000 clustered
+// ---------------------------------------------------------------------
+
+constexpr char g_benchFilename[] = "bench.db";
+constexpr int g_itemCount = 150;
+
+using table = bannerStatements<Banner::Character>;
+
+// Results of scans are written here, so compiler can't drop the loops
+static volatile long long g_sink;
+
+static void check(int rc, sqlite3* handle, const char* what)
+{
+	if (rc != SQLITE_OK && rc != SQLITE_DONE && rc != SQLITE_ROW)
+	{
+		std::cout << "error: " << what << ": " << sqlite3_errmsg(handle) << std::endl;
+		exit(1);
+	}
+}
+
+static void exec(sqlite3* handle, const char* sql)
+{
+	check(sqlite3_exec(handle, sql, nullptr, nullptr, nullptr), handle, sql);
+}
+
+// Runs work once and prints how long it took and how many rows per second that is
+static void measure(const char* name, long long rows, const std::function<void()> &work)
+{
+	auto start = std::chrono::steady_clock::now();
+	work();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+		<< elapsed.count() << " ms" << std::setw(14) << std::setprecision(0) << rows / (elapsed.count() / 1000.0) << " rows/s\n";
+}
+
+static sqlite3* openBenchDb(bool clustered)
+{
+	std::remove(g_benchFilename);
+	std::remove((std::string(g_benchFilename) + "-wal").c_str());
+	std::remove((std::string(g_benchFilename) + "-shm").c_str());
+
+	sqlite3* handle;
+	check(sqlite3_open(g_benchFilename, &handle), handle, "open");
+	exec(handle, "PRAGMA journal_mode=WAL;");
+	exec(handle, "PRAGMA synchronous=NORMAL;");
+	exec(handle, "CREATE TABLE items (id integer PRIMARY KEY, itemType integer NOT NULL, itemName text NOT NULL, UNIQUE(itemName, itemType));");
+	if (clustered)
+	{
+		exec(handle, table::createClusteredTable.c_str());
+	}
+	else
+	{
+		exec(handle, table::createTable.c_str());
+		exec(handle, table::createKeyIndex.c_str());
+	}
+
+	exec(handle, "BEGIN;");
+	for (int i = 0; i < g_itemCount; i++)
+	{
+		std::string sql = "INSERT INTO items(id, itemType, itemName) VALUES(" + std::to_string(i) + ", " + std::to_string(1 + i % 2) +
+			", 'item " + std::to_string(i) + "');";
+		exec(handle, sql.c_str());
+	}
+	exec(handle, "COMMIT;");
+	return handle;
+}
+
+// 10 wishes per timestamp, as a 10-pull stores them
+static void insertWishes(sqlite3* handle, sqlite3_stmt* insert, long long from, long long count)
+{
+	for (long long i = from; i < from + count; i++)
+	{
+		sqlite3_bind_int(insert, 1, static_cast<int>(i % g_itemCount));
+		sqlite3_bind_int64(insert, 2, 1600000000 + i / 10);
+		sqlite3_bind_int(insert, 3, i % 60 == 0 ? 5 : (i % 10 == 0 ? 4 : 3));
+		sqlite3_bind_int64(insert, 4, i % 10);
+		check(sqlite3_step(insert), handle, "insert");
+		sqlite3_reset(insert);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// whole 10-pulls, so later inserts never reuse a key
+	long long rows = std::max(argc > 1 ? std::atoll(argv[1]) / 10 * 10 : 100000, 10LL);
+	bool clustered = argc > 2 && std::string(argv[2]) == "clustered";
+
+	std::cout << "sqlite " << sqlite3_libversion() << ", threadsafe " << sqlite3_threadsafe() << "\n";
+	for (int i = 0; const char* option = sqlite3_compileoption_get(i); i++)
+	{
+		std::cout << "\t" << option << "\n";
+	}
+	std::cout << rows << " wishes, " << (clustered ? "clustered" : "rowid") << " layout\n\n";
+
+	sqlite3* handle = openBenchDb(clustered);
+	sqlite3_stmt* insert;
+	check(sqlite3_prepare_v2(handle, table::insertWish.c_str(), -1, &insert, nullptr), handle, "prepare insert");
+
+	measure("bulk insert (1 transaction)", rows, [&] {
+		exec(handle, "BEGIN;");
+		insertWishes(handle, insert, 0, rows);
+		exec(handle, "COMMIT;");
+	});
+
+	long long pulls = std::min(rows / 10, 2000LL) * 10;
+	measure("10-pull transactions", pulls, [&] {
+		for (long long i = 0; i < pulls; i += 10)
+		{
+			exec(handle, "BEGIN;");
+			insertWishes(handle, insert, rows + i, 10);
+			exec(handle, "COMMIT;");
+		}
+	});
+	sqlite3_finalize(insert);
+	rows += pulls;
+
+	sqlite3_stmt* select;
+	check(sqlite3_prepare_v2(handle, clustered ? table::selectCompactWishesInTimeOrder.c_str() : table::selectCompactWishes.c_str(),
+		-1, &select, nullptr), handle, "prepare select");
+	measure("compact scan", rows, [&] {
+		long long sum = 0;
+		while (sqlite3_step(select) == SQLITE_ROW)
+		{
+			sum += sqlite3_column_int64(select, 1);
+		}
+		sqlite3_reset(select);
+		g_sink = sum;
+	});
+	sqlite3_finalize(select);
+
+	check(sqlite3_prepare_v2(handle, clustered ? table::selectWishesInTimeOrder.c_str() : table::selectWishes.c_str(),
+		-1, &select, nullptr), handle, "prepare join");
+	measure("scan joined with items", rows, [&] {
+		size_t bytes = 0;
+		while (sqlite3_step(select) == SQLITE_ROW)
+		{
+			bytes += sqlite3_column_bytes(select, 1);
+		}
+		sqlite3_reset(select);
+		g_sink = bytes;
+	});
+	sqlite3_finalize(select);
+
+	long long lookups = std::min(rows / 10, 50000LL);
+	check(sqlite3_prepare_v2(handle, table::selectNextSeq.c_str(), -1, &select, nullptr), handle, "prepare lookup");
+	measure("key index lookups", lookups, [&] {
+		for (long long i = 0; i < lookups; i++)
+		{
+			sqlite3_bind_int64(select, 1, 1600000000 + (i * 7919) % (rows / 10));
+			check(sqlite3_step(select), handle, "lookup");
+			sqlite3_reset(select);
+		}
+	});
+	sqlite3_finalize(select);
+
+	sqlite3_close(handle);
+	return 0;
+}
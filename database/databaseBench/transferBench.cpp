@@ -0,0 +1,97 @@
+#include "../src/logDb.h"
+#include "../src/wishTransfer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <functional>
+
+// ---------------------------------------------------------------------
+// TRANSFER BENCHMARK
+// Export and import of CSV and JSON lines (wishTransfer.h), reported in MB/s of the file.
+// History comes from LogDatabase, import goes into a backend that only counts wishes (parser speed)
+// and into a fresh LogDatabase (whole path to the disk).
+// Example usecase:		transferBench 1000000
+// ---------------------------------------------------------------------
+
+constexpr int g_itemCount = 150;
+
+// Takes wishes without storing them, so only reading and parsing is measured
+class countingDatabase : public Database
+{
+public:
+	using Database::getWishes;
+	using Database::insertWishes;
+	void getWishes(Banner, std::vector<wishEntry> &wishList) override { wishList.clear(); }
+	void insertWishes(Banner, std::span<const wishEntry> wishes) override { count += wishes.size(); }
+	void insertWishes(Banner, std::span<const compactWish> wishes) override { count += wishes.size(); }
+
+	size_t count = 0;
+};
+
+// Runs work once and prints how long it took, MB/s of the file and rows per second
+static void measure(const char* name, long long rows, const std::function<size_t()> &work)
+{
+	auto start = std::chrono::steady_clock::now();
+	size_t bytes = work();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << std::left << std::setw(34) << name << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+		<< elapsed.count() * 1000.0 << " ms" << std::setw(10) << std::setprecision(1) << bytes / elapsed.count() / (1 << 20) << " MB/s"
+		<< std::setw(14) << std::setprecision(0) << rows / elapsed.count() << " rows/s\n";
+}
+
+int main(int argc, char** argv)
+{
+	long long rows = std::max(argc > 1 ? std::atoll(argv[1]) / 10 * 10 : 1000000, 10LL);
+	std::filesystem::remove_all("transferBenchSource");
+	std::filesystem::remove_all("transferBenchTarget");
+
+	// 10 wishes per timestamp, as a 10-pull stores them
+	LogDatabase source("transferBenchSource", 64 << 20);
+	{
+		StringInterner &interner = StringInterner::getInstance();
+		std::vector<compactWish> wishes;
+		wishes.reserve(static_cast<size_t>(rows));
+		for (long long i = 0; i < rows; i++)
+		{
+			std::uint32_t item = interner.intern("item " + std::to_string(i % g_itemCount));
+			wishes.push_back(compactWish{ 1600000000 + i / 10, item, i % 2 ? wishItemType::Weapon : wishItemType::Character,
+				static_cast<std::uint8_t>(i % 60 == 0 ? 5 : (i % 10 == 0 ? 4 : 3)) });
+		}
+		source.insertWishes(Banner::Character, std::span<const compactWish>(wishes));
+	}
+	std::cout << rows << " wishes, " << g_transferChunkBytes / 1024 << " KiB chunks\n\n";
+
+	for (transferFormat format : { transferFormat::Csv, transferFormat::JsonLines })
+	{
+		bool csv = format == transferFormat::Csv;
+		std::string path = csv ? "transferBench.csv" : "transferBench.jsonl";
+		transferStats stats;
+
+		measure(csv ? "CSV export" : "JSON lines export", rows, [&] {
+			exportHistory(source, path, format, &stats);
+			return stats.bytes;
+		});
+
+		countingDatabase counter;
+		measure(csv ? "CSV parse" : "JSON lines parse", rows, [&] {
+			importHistory(counter, path, format, false, &stats);
+			return stats.bytes;
+		});
+
+		std::filesystem::remove_all("transferBenchTarget");
+		LogDatabase target("transferBenchTarget", 64 << 20);
+		measure(csv ? "CSV import (LogDatabase)" : "JSON lines import (LogDatabase)", rows, [&] {
+			importHistory(target, path, format, false, &stats);
+			return stats.bytes;
+		});
+		std::filesystem::remove(path);
+	}
+
+	std::filesystem::remove_all("transferBenchSource");
+	std::filesystem::remove_all("transferBenchTarget");
+	return 0;
+}
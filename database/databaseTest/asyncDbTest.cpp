@@ -0,0 +1,129 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/asyncDb.h"
+#include "utilityTest.h"
+
+// ---------------------------------------------------------------------
+// ASYNC DB TEST
+// ---------------------------------------------------------------------
+
+class AsyncSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+};
+
+TEST_F(AsyncSuite, InsertAsyncAndGetWishes)
+{
+	std::string filename = "asyncTest.db";
+	AsyncDatabase db(std::make_unique<SQLDatabase>(filename));
+
+	std::vector<std::future<void>> futures;
+	for (int i = 0; i < 50; i++)
+	{
+		wishEntry wish("Weapon", "Slingshot", "2021-01-12 18:39:" + std::to_string(10 + i % 50), 3);
+		futures.push_back(db.insertWishAsync(Banner::Weapon, wish));
+	}
+	std::vector<wishEntry> wishVec = {
+		wishEntry("Character", "Ganyu", "2021-01-12 18:40:00", 5),
+		wishEntry("Character", "Xingqiu", "2021-01-12 18:40:00", 4) };
+	futures.push_back(db.insertWishesAsync(Banner::Weapon, wishVec));
+
+	for (auto &future : futures)
+	{
+		future.get();
+	}
+
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Weapon, wishList);
+
+	ASSERT_EQ(wishList.size(), 52);
+	EXPECT_EQ(wishList[0].date, "2021-01-12 18:39:10");
+	EXPECT_EQ(wishList[49].date, "2021-01-12 18:39:59");
+	EXPECT_EQ(wishList[50].itemName, "Ganyu");
+	EXPECT_EQ(wishList[51].itemName, "Xingqiu");
+}
+
+TEST_F(AsyncSuite, ShutdownWritesEverythingQueued)
+{
+	std::string filename = "asyncTest.db";
+	{
+		AsyncDatabase db(std::make_unique<SQLDatabase>(filename));
+		for (int i = 0; i < 20; i++)
+		{
+			db.insertWish(Banner::Beginner, wishEntry("Character", "Noelle", "2020-09-28 10:00:00", 4));
+		}
+		// no flush, destructor has to drain the queue
+	}
+
+	SQLDatabase db(filename);
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Beginner, wishList);
+	EXPECT_EQ(wishList.size(), 20);
+}
+
+TEST_F(AsyncSuite, FailedWriteFailsFutures)
+{
+	std::string filename = "asyncFailTest.db";
+	AsyncDatabase db(std::make_unique<SQLDatabase>(filename));
+	db.flush();
+
+	// stats row is written in the same transaction as the wishes, so failing it rolls the whole batch back
+	sqlite3* handle;
+	ASSERT_EQ(sqlite3_open(filename.c_str(), &handle), SQLITE_OK);
+	ASSERT_EQ(sqlite3_exec(handle, "CREATE TRIGGER failStats BEFORE INSERT ON bannerStats BEGIN SELECT RAISE(ABORT, 'forced'); END;",
+		nullptr, nullptr, nullptr), SQLITE_OK);
+	auto failed = db.insertWishAsync(Banner::Weapon, wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3));
+	EXPECT_THROW(failed.get(), std::runtime_error);
+
+	ASSERT_EQ(sqlite3_exec(handle, "DROP TRIGGER failStats;", nullptr, nullptr, nullptr), SQLITE_OK);
+	sqlite3_close(handle);
+	auto stored = db.insertWishAsync(Banner::Weapon, wishEntry("Weapon", "Raven Bow", "2021-01-12 18:40:00", 3));
+	EXPECT_NO_THROW(stored.get());
+
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Weapon, wishList);
+	ASSERT_EQ(wishList.size(), 1);
+	EXPECT_EQ(wishList[0].itemName, "Raven Bow");
+}
+
+TEST_F(AsyncSuite, FailedWishInsertFailsFutures)
+{
+	std::string filename = "asyncFailWishTest.db";
+	AsyncDatabase db(std::make_unique<SQLDatabase>(filename));
+	db.flush();
+
+	// failing insert of the wish itself must roll back the batch, not commit what is left of it
+	sqlite3* handle;
+	ASSERT_EQ(sqlite3_open(filename.c_str(), &handle), SQLITE_OK);
+	ASSERT_EQ(sqlite3_exec(handle, "CREATE TRIGGER failWish BEFORE INSERT ON wishWeapon BEGIN SELECT RAISE(ABORT, 'forced'); END;",
+		nullptr, nullptr, nullptr), SQLITE_OK);
+	auto failed = db.insertWishAsync(Banner::Weapon, wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3));
+	EXPECT_THROW(failed.get(), std::runtime_error);
+	ASSERT_EQ(sqlite3_exec(handle, "DROP TRIGGER failWish;", nullptr, nullptr, nullptr), SQLITE_OK);
+	sqlite3_close(handle);
+
+	EXPECT_EQ(db.getStats(Banner::Weapon).total, 0);
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Weapon, wishList);
+	EXPECT_TRUE(wishList.empty());
+}
+
+TEST_F(AsyncSuite, InvalidDateFailsRequest)
+{
+	AsyncDatabase db(std::make_unique<SQLDatabase>("asyncInvalidDateTest.db"));
+	auto invalid = db.insertWishesAsync(Banner::Weapon, std::vector<wishEntry>{
+		wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3),
+		wishEntry("Weapon", "Raven Bow", "yesterday", 3) });
+	auto valid = db.insertWishAsync(Banner::Weapon, wishEntry("Weapon", "Debate Club", "2021-01-12 18:40:00", 3));
+	EXPECT_THROW(invalid.get(), std::invalid_argument);
+	EXPECT_NO_THROW(valid.get());
+
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Weapon, wishList);
+	ASSERT_EQ(wishList.size(), 1);
+	EXPECT_EQ(wishList[0].itemName, "Debate Club");
+}
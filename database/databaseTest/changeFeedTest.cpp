@@ -0,0 +1,112 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/changeFeed.h"
+#include "utilityTest.h"
+#include <thread>
+
+// ---------------------------------------------------------------------
+// CHANGE FEED TEST
+// ---------------------------------------------------------------------
+
+class ChangeFeedSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+
+	std::vector<wishEntry> tenPull(const std::string &date)
+	{
+		std::vector<wishEntry> wishes;
+		for (int i = 0; i < 10; i++)
+		{
+			wishes.emplace_back("Weapon", i == 9 ? "Skyward Harp" : "Slingshot", date, i == 9 ? 5 : 3);
+		}
+		return wishes;
+	}
+};
+
+TEST_F(ChangeFeedSuite, PublishesCommittedInserts)
+{
+	SQLDatabase db("changeFeedTest.db");
+	std::vector<wishBatch> batches;
+	size_t subscription = db.subscribe([&](const wishBatch &batch) { batches.push_back(batch); });
+
+	db.insertWishes(Banner::Weapon, tenPull("2021-01-12 18:37:29"));
+	db.insertWish(Banner::Character, wishEntry("Character", "Ganyu", "2021-01-12 18:40:00", 5));
+	ASSERT_EQ(batches.size(), 2);
+
+	EXPECT_EQ(batches[0].banner, Banner::Weapon);
+	ASSERT_EQ(batches[0].wishes.size(), 10);
+	EXPECT_EQ(batches[0].lastRow - batches[0].firstRow, 9);
+	EXPECT_EQ(StringInterner::getInstance().name(batches[0].wishes[9].itemId), "Skyward Harp");
+	EXPECT_EQ(batches[0].wishes[9].itemRarity, 5);
+	EXPECT_EQ(batches[0].wishes[0].time, dateToEpoch("2021-01-12 18:37:29"));
+
+	EXPECT_EQ(batches[1].banner, Banner::Character);
+	ASSERT_EQ(batches[1].wishes.size(), 1);
+	EXPECT_EQ(toWishEntry(batches[1].wishes[0]).itemName, "Ganyu");
+
+	// import of stored history publishes only what is new
+	batches.clear();
+	auto history = tenPull("2021-01-12 18:37:29");
+	EXPECT_EQ(db.importWishes(Banner::Weapon, history), 0);
+	EXPECT_TRUE(batches.empty());
+	auto newer = tenPull("2021-01-13 10:00:00");
+	history.insert(history.end(), newer.begin(), newer.end());
+	EXPECT_EQ(db.importWishes(Banner::Weapon, history), 10);
+	ASSERT_EQ(batches.size(), 1);
+	EXPECT_EQ(batches[0].wishes.size(), 10);
+	EXPECT_EQ(batches[0].wishes[0].time, dateToEpoch("2021-01-13 10:00:00"));
+
+	batches.clear();
+	db.unsubscribe(subscription);
+	db.insertWishes(Banner::Weapon, tenPull("2021-01-14 10:00:00"));
+	EXPECT_TRUE(batches.empty());
+}
+
+TEST_F(ChangeFeedSuite, RolledBackRowsAreDropped)
+{
+	sqlite3* handle;
+	ASSERT_EQ(sqlite3_open(":memory:", &handle), SQLITE_OK);
+	ChangeFeed feed;
+	feed.attach(handle);
+	sqlite3_exec(handle, sqlFor(Banner::Standard).createTable, nullptr, nullptr, nullptr);
+	sqlite3_exec(handle, "CREATE TABLE other (id integer PRIMARY KEY);", nullptr, nullptr, nullptr);
+
+	sqlite3_exec(handle, "BEGIN; INSERT INTO wishStandard(itemId, timeReceived, itemRarity) VALUES (1, 1, 3); ROLLBACK;", nullptr, nullptr, nullptr);
+	EXPECT_TRUE(feed.takeCommitted()[static_cast<size_t>(Banner::Standard)].empty());
+
+	sqlite3_exec(handle, "BEGIN; INSERT INTO other DEFAULT VALUES;"
+		"INSERT INTO wishStandard(itemId, timeReceived, itemRarity) VALUES (1, 2, 3), (1, 3, 3); COMMIT;", nullptr, nullptr, nullptr);
+	auto committed = feed.takeCommitted();
+	EXPECT_EQ(committed[static_cast<size_t>(Banner::Standard)].last - committed[static_cast<size_t>(Banner::Standard)].first, 1);
+	EXPECT_TRUE(committed[static_cast<size_t>(Banner::Character)].empty());
+	EXPECT_TRUE(feed.takeCommitted()[static_cast<size_t>(Banner::Standard)].empty());
+
+	feed.detach(handle);
+	sqlite3_close(handle);
+}
+
+TEST_F(ChangeFeedSuite, QueueHandsBatchesToOtherThread)
+{
+	SQLDatabase db("changeFeedTest.db");
+	WishBatchQueue queue;
+	db.subscribe(queue.callback());
+
+	size_t received = 0;
+	std::thread viewer([&] {
+		wishBatch batch;
+		while (received < 20 && queue.pop(batch, std::chrono::milliseconds(2000)))
+		{
+			received += batch.wishes.size();
+		}
+	});
+	db.insertWishes(Banner::Character, tenPull("2021-02-01 10:00:00"));
+	db.insertWishes(Banner::Character, tenPull("2021-02-02 10:00:00"));
+	viewer.join();
+
+	EXPECT_EQ(received, 20);
+	EXPECT_EQ(queue.size(), 0);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/connectionPool.h"
+#include "utilityTest.h"
+
+// ---------------------------------------------------------------------
+// CONNECTION POOL TEST
+// ---------------------------------------------------------------------
+
+class PoolSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+};
+
+TEST_F(PoolSuite, CheckoutAndCheckin)
+{
+	std::string filename = "poolTest.db";
+	SQLDatabase db(filename);
+	SQLConnectionPool pool(filename, 2);
+	EXPECT_EQ(pool.size(), 2);
+
+	sqlite3* first = pool.checkout();
+	sqlite3* second = pool.checkout();
+	ASSERT_NE(first, nullptr);
+	ASSERT_NE(second, nullptr);
+	EXPECT_NE(first, second);
+
+	pool.checkin(first);
+	sqlite3* third = pool.checkout();
+	EXPECT_EQ(third, first) << "Idle connection should be reused, not reopened";
+
+	pool.checkin(second);
+	pool.checkin(third);
+
+	// connections are read-only
+	char* errMsg = 0;
+	auto conn = pool.connection();
+	int rc = sqlite3_exec(conn.get(), "DELETE FROM wishCharacter;", NULL, 0, &errMsg);
+	EXPECT_EQ(rc, SQLITE_READONLY);
+	sqlite3_free(errMsg);
+}
+
+TEST_F(PoolSuite, ConcurrentReadsOfAllTables)
+{
+	std::string filename = "poolTest.db";
+	SQLDatabase db(filename);
+	for (size_t i = 0; i < g_bannerCount; i++)
+	{
+		std::vector<wishEntry> wishVec(10 * (i + 1), wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3));
+		db.insertWishes(g_banners[i], std::move(wishVec));
+	}
+
+	SQLConnectionPool pool(filename, g_bannerCount);
+	std::vector<std::vector<wishEntry>> results(g_bannerCount);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < g_bannerCount; i++)
+	{
+		threads.emplace_back([&, i] { pool.getWishes(g_banners[i], results[i]); });
+	}
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	for (size_t i = 0; i < g_bannerCount; i++)
+	{
+		EXPECT_EQ(results[i].size(), 10 * (i + 1)) << bannerTableName(g_banners[i]);
+	}
+}
+
+TEST_F(PoolSuite, LoadAllBanners)
+{
+	std::string filename = "poolLoadAllTest.db";
+	SQLDatabase db(filename);
+	for (size_t i = 0; i < g_bannerCount; i++)
+	{
+		std::vector<wishEntry> wishVec(100 * (i + 1), wishEntry("Character", "Ganyu", "2021-01-12 18:39:21", 5));
+		db.insertWishes(g_banners[i], std::move(wishVec));
+	}
+
+	// pool smaller than number of banners has to work too
+	for (size_t size : { g_bannerCount, size_t(1) })
+	{
+		SQLConnectionPool pool(filename, size);
+		std::array<std::vector<wishEntry>, g_bannerCount> all;
+		pool.loadAll(all);
+		for (size_t i = 0; i < g_bannerCount; i++)
+		{
+			std::vector<wishEntry> expected;
+			db.getWishes(g_banners[i], expected);
+			ASSERT_EQ(all[i].size(), expected.size()) << bannerTableName(g_banners[i]);
+			EXPECT_EQ(all[i].size(), 100 * (i + 1));
+			// reserved once from rowid range, never grown
+			EXPECT_EQ(all[i].capacity(), all[i].size());
+			EXPECT_EQ(all[i].back().itemName, expected.back().itemName);
+		}
+	}
+}
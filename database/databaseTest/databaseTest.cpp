@@ -1,8 +1,11 @@
 #include <gtest/gtest.h> // googletest header file
 
 #include "../src/db.h"
+#include "../src/changeFeed.h"
+#include "../src/connectionPool.h"
 #include "utilityTest.h"
 #include <filesystem>
+#include <algorithm>
 
 // ---------------------------------------------------------------------
 // SQLITE DB TEST
@@ -79,7 +82,129 @@ TEST_F(SQLSuite, FirstTimeCreatingDbWithDiffFilename)
 
 TEST_F(SQLSuite, UpgradeDb)
 {
-	//TBD...
+	std::string filename = "upgradeTest.db";
+	std::vector<wishEntry> wishList = {
+		wishEntry("Weapon", "Skyrider Sword", "2021-01-12 18:37:29", 3),
+		wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5),
+		wishEntry("Weapon", "Skyrider Sword", "2021-01-12 18:39:21", 3),
+		wishEntry("Character", "Xingqiu", "2021-01-12 18:39:21", 4) };
+	dbTest::createV1Db(filename, wishList);
+
+	std::vector<migrationProgress> progress;
+	std::unique_ptr<Database> db = std::make_unique<SQLDatabase>(filename,
+		[&](const migrationProgress &p) { progress.push_back(p); });
+
+	sqlite3* cHandle;
+	sqlite3_open(filename.c_str(), &cHandle);
+	std::unordered_set<std::string> tables;
+	dbTest::getTables(cHandle, tables);
+	EXPECT_EQ(tables.contains("items"), true);
+	EXPECT_EQ(dbTest::getVersion(cHandle), g_version);
+	EXPECT_EQ(dbTest::getUserVersion(cHandle), g_version);
+	sqlite3_close(cHandle);
+
+	ASSERT_FALSE(progress.empty());
+	auto character = std::find_if(progress.begin(), progress.end(), [](auto &p) { return p.table == "wishCharacter"; });
+	ASSERT_NE(character, progress.end());
+	EXPECT_EQ(progress.back().rowsDone, progress.back().rowsTotal);
+
+	std::vector<wishEntry> wishList2;
+	db->getWishes(Banner::Character, wishList2);
+	ASSERT_EQ(wishList2.size(), wishList.size());
+	for (size_t i = 0; i < wishList.size(); i++)
+	{
+		EXPECT_EQ(wishList[i].itemType, wishList2[i].itemType);
+		EXPECT_EQ(wishList[i].itemName, wishList2[i].itemName);
+		EXPECT_EQ(wishList[i].date, wishList2[i].date);
+		EXPECT_EQ(wishList[i].itemRarity, wishList2[i].itemRarity);
+	}
+
+	// v3 numbered migrated rows, so they are recognized by import
+	EXPECT_EQ(db->importWishes(Banner::Character, wishList), 0);
+	// v4 filled bannerStats from migrated history
+	wishStats stats = db->getStats(Banner::Character);
+	EXPECT_EQ(stats.total, 4);
+	EXPECT_EQ(stats.count5, 1);
+	EXPECT_EQ(stats.pity5, 2);
+}
+
+TEST_F(SQLSuite, FailedUpgradeKeepsOldVersion)
+{
+	std::string filename = "failedUpgradeTest.db";
+	dbTest::createV1Db(filename, { wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5) });
+
+	// Missing wish table makes upgrade step fail halfway
+	sqlite3* cHandle;
+	sqlite3_open(filename.c_str(), &cHandle);
+	sqlite3_exec(cHandle, "DROP TABLE wishBeginner;", NULL, 0, NULL);
+	sqlite3_close(cHandle);
+
+	EXPECT_EXIT(SQLDatabase db(filename), ::testing::ExitedWithCode(1), "");
+
+	sqlite3_open(filename.c_str(), &cHandle);
+	std::unordered_set<std::string> tables;
+	dbTest::getTables(cHandle, tables);
+	EXPECT_EQ(tables.contains("items"), false);
+	EXPECT_EQ(tables.contains("wishCharacter_v2"), false);
+	EXPECT_EQ(dbTest::getVersion(cHandle), 1);
+	EXPECT_EQ(dbTest::getUserVersion(cHandle), 0);
+	sqlite3_close(cHandle);
+}
+
+TEST_F(SQLSuite, UnparsableDateFailsUpgrade)
+{
+	std::string filename = "badDateUpgradeTest.db";
+	dbTest::createV1Db(filename, {
+		wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5),
+		wishEntry("Character", "Xingqiu", "12/01/2021 18:39", 4) });
+
+	// Wish with a date that can't be converted must not end up as 1970
+	EXPECT_EXIT(SQLDatabase db(filename), ::testing::ExitedWithCode(1), "");
+
+	sqlite3* cHandle;
+	sqlite3_open(filename.c_str(), &cHandle);
+	EXPECT_EQ(dbTest::getVersion(cHandle), 1);
+	EXPECT_EQ(dbTest::column(cHandle, "SELECT timeReceived FROM wishCharacter WHERE itemName = 'Xingqiu';"), std::vector<std::string>{ "12/01/2021 18:39" });
+	sqlite3_close(cHandle);
+}
+
+TEST_F(SQLSuite, HeaderSkipsSchemaProbe)
+{
+	std::string filename = "customName.db";
+	{
+		SQLDatabase db(filename);
+	}
+
+	sqlite3* cHandle;
+	sqlite3_open(filename.c_str(), &cHandle);
+	sqlite3_stmt* stmt;
+	sqlite3_prepare_v2(cHandle, "PRAGMA application_id;", -1, &stmt, NULL);
+	ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+	EXPECT_EQ(sqlite3_column_int(stmt, 0), g_applicationId);
+	sqlite3_finalize(stmt);
+	EXPECT_EQ(dbTest::getUserVersion(cHandle), g_version);
+
+	// Without systemInfo the slow path would treat file as empty and create it again
+	sqlite3_exec(cHandle, "DROP TABLE systemInfo;", NULL, 0, NULL);
+	sqlite3_close(cHandle);
+	{
+		SQLDatabase db(filename);
+	}
+
+	sqlite3_open(filename.c_str(), &cHandle);
+	std::unordered_set<std::string> tables;
+	dbTest::getTables(cHandle, tables);
+	EXPECT_EQ(tables.contains("systemInfo"), false);
+	sqlite3_close(cHandle);
+}
+
+TEST_F(SQLSuite, DateEpochConversion)
+{
+	EXPECT_EQ(dateToEpoch("2020-11-07 14:53:16"), 1604760796);
+	EXPECT_EQ(epochToDate(1604760796), "2020-11-07 14:53:16");
+	EXPECT_EQ(epochToDate(dateToEpoch("2024-02-29 23:59:59")), "2024-02-29 23:59:59");
+	EXPECT_EQ(dateToEpoch("2023-02-29 10:00:00"), -1);
+	EXPECT_EQ(dateToEpoch("10.10.22 15:15"), -1);
 }
 
 TEST_F(SQLSuite, DbNewerThanApp)
@@ -90,13 +215,13 @@ TEST_F(SQLSuite, DbNewerThanApp)
 TEST_F(SQLSuite, InsertAndGetWish)
 {
 	std::unique_ptr<Database> db = std::make_unique<SQLDatabase>();
-	std::string tableName = "wishStandard";
+	Banner banner = Banner::Standard;
 	wishEntry wish("Character", "Diluc", "2020-11-07 14:53:16", 5);
 	
-	db->insertWish(tableName, wish);
+	db->insertWish(banner, wish);
 	
 	std::vector<wishEntry> wishList;
-	db->getWishes(tableName, wishList);
+	db->getWishes(banner, wishList);
 
 	EXPECT_EQ(wishList[0].itemType, wish.itemType);
 	EXPECT_EQ(wishList[0].itemName, wish.itemName);
@@ -107,7 +232,7 @@ TEST_F(SQLSuite, InsertAndGetWish)
 TEST_F(SQLSuite, InsertAndGet6Wishes)
 {
 	std::unique_ptr<Database> db = std::make_unique<SQLDatabase>();
-	std::string tableName = "wishCharacter";
+	Banner banner = Banner::Character;
 
 	wishEntry wish1("Weapon", "Skyrider Sword", "2021-01-12 18:37:29", 3);
 	wishEntry wish2("Character", "Ganyu", "2021-01-12 18:37:29", 5);
@@ -117,12 +242,12 @@ TEST_F(SQLSuite, InsertAndGet6Wishes)
 	wishEntry wish6("Weapon", "Slingshot", "2021-01-12 18:39:21", 3);
 	std::vector<wishEntry> wishList = { wish1, wish2, wish3, wish4, wish5, wish6 };
 
-	db->insertWishes(tableName, wishList);
+	db->insertWishes(banner, wishList);
 
 	std::vector<wishEntry> wishList2;
-	db->getWishes(tableName, wishList2);
+	db->getWishes(banner, wishList2);
 
-	for (int i = 0; i < wishList.size(); i++)
+	for (size_t i = 0; i < wishList.size(); i++)
 	{
 		EXPECT_EQ(wishList[i].itemType, wishList2[i].itemType);
 		EXPECT_EQ(wishList[i].itemName, wishList2[i].itemName);
@@ -130,3 +255,263 @@ TEST_F(SQLSuite, InsertAndGet6Wishes)
 		EXPECT_EQ(wishList[i].itemRarity, wishList2[i].itemRarity);
 	}
 }
+
+TEST_F(SQLSuite, InsertAndGetCompactWishes)
+{
+	std::unique_ptr<Database> db = std::make_unique<SQLDatabase>("compactTest.db");
+	Banner banner = Banner::Weapon;
+
+	std::vector<wishEntry> wishList = {
+		wishEntry("Weapon", "Skyrider Sword", "2021-01-12 18:37:29", 3),
+		wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5) };
+	db->insertWishes(banner, wishList);
+
+	// compact and regular api are views of the same rows
+	std::vector<compactWish> compactList = { toCompactWish(wishEntry("Weapon", "Skyrider Sword", "2021-01-13 10:00:00", 3)) };
+	db->insertWishes(banner, compactList);
+
+	std::vector<compactWish> compactList2;
+	db->getWishes(banner, compactList2);
+	ASSERT_EQ(compactList2.size(), 3);
+	EXPECT_EQ(compactList2[0].itemId, compactList2[2].itemId);
+	EXPECT_EQ(compactList2[1].itemType, wishItemType::Character);
+	EXPECT_EQ(compactList2[1].itemRarity, 5);
+	EXPECT_EQ(compactList2[1].time, dateToEpoch("2021-01-12 18:37:29"));
+
+	std::vector<wishEntry> wishList2;
+	db->getWishes(banner, wishList2);
+	ASSERT_EQ(wishList2.size(), 3);
+	EXPECT_EQ(wishList2[2].itemName, "Skyrider Sword");
+	EXPECT_EQ(wishList2[2].date, "2021-01-13 10:00:00");
+}
+
+TEST_F(SQLSuite, BannerSqlAndCachedStatements)
+{
+	static_assert(std::string_view(bannerStatements<Banner::Standard>::selectCompactWishes.c_str()) ==
+		"SELECT itemId, timeReceived, itemRarity FROM wishStandard ORDER BY id;");
+	static_assert(std::string_view(bannerStatements<Banner::Weapon>::insertWish.c_str()) ==
+		"INSERT INTO wishWeapon(itemId, timeReceived, itemRarity, seq) VALUES(?, ?, ?, ?);");
+	EXPECT_STREQ(bannerTableName(Banner::Beginner), "wishBeginner");
+	EXPECT_STREQ(sqlFor(Banner::Character).createTable, bannerStatements<Banner::Character>::createTable.c_str());
+
+	// Same prepared statements are stepped again for every call
+	SQLDatabase db("compactTest.db");
+	std::vector<wishEntry> before, after;
+	db.getWishes(Banner::Beginner, before);
+	db.insertWish(Banner::Beginner, wishEntry("Character", "Noelle", "2020-09-28 10:00:00", 4));
+	db.insertWish(Banner::Beginner, wishEntry("Weapon", "Slingshot", "2020-09-28 10:00:01", 3));
+	db.getWishes(Banner::Beginner, after);
+	ASSERT_EQ(after.size(), before.size() + 2);
+	EXPECT_EQ(after.back().itemName, "Slingshot");
+}
+
+TEST_F(SQLSuite, ImportSkipsStoredWishes)
+{
+	std::unique_ptr<Database> db = std::make_unique<SQLDatabase>("importTest.db");
+	// 10-pull can have the same item more than once, seq tells them apart
+	std::vector<wishEntry> firstPage = {
+		wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3),
+		wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3),
+		wishEntry("Character", "Xingqiu", "2021-01-12 18:39:21", 4) };
+	std::vector<wishEntry> overlapping = firstPage;
+	overlapping.push_back(wishEntry("Character", "Ganyu", "2021-01-13 10:00:00", 5));
+
+	EXPECT_EQ(db->importWishes(Banner::Character, firstPage), 3);
+	EXPECT_EQ(db->importWishes(Banner::Character, overlapping), 1);
+	EXPECT_EQ(db->importWishes(Banner::Character, overlapping), 0);
+
+	// Append doesn't deduplicate, seq continues after stored wishes of the same time
+	db->insertWishes(Banner::Character, firstPage);
+
+	std::vector<wishEntry> wishList;
+	db->getWishes(Banner::Character, wishList);
+	EXPECT_EQ(wishList.size(), 7);
+
+	// Fresh connection has to load keys from db and still skip everything
+	db = std::make_unique<SQLDatabase>("importTest.db");
+	EXPECT_EQ(db->importWishes(Banner::Character, overlapping), 0);
+	db->getWishes(Banner::Character, wishList);
+	EXPECT_EQ(wishList.size(), 7);
+}
+
+TEST_F(SQLSuite, StatsFollowInserts)
+{
+	std::vector<wishEntry> wishList = {
+		wishEntry("Weapon", "Slingshot", "2021-01-12 18:37:29", 3),
+		wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5),
+		wishEntry("Weapon", "Raven Bow", "2021-01-12 18:39:21", 3),
+		wishEntry("Character", "Xingqiu", "2021-01-13 10:00:00", 4),
+		wishEntry("Weapon", "Raven Bow", "2021-01-14 09:00:00", 3) };
+	{
+		SQLDatabase db("statsTest.db");
+		db.insertWishes(Banner::Character, wishList);
+		wishStats stats = db.getStats(Banner::Character);
+		EXPECT_EQ(stats.total, 5);
+		EXPECT_EQ(stats.count3, 3);
+		EXPECT_EQ(stats.pity4, 1);
+		EXPECT_EQ(stats.pity5, 3);
+		EXPECT_EQ(stats.last5Time, dateToEpoch("2021-01-12 18:37:29"));
+		EXPECT_EQ(stats, db.Database::getStats(Banner::Character));
+
+		// Older than everything stored, pity of every later wish changes
+		db.insertWish(Banner::Character, wishEntry("Character", "Diluc", "2021-01-11 10:00:00", 5));
+		EXPECT_EQ(db.getStats(Banner::Character), db.Database::getStats(Banner::Character));
+	}
+
+	// Read back from bannerStats by a new connection
+	SQLDatabase db("statsTest.db");
+	wishStats stats = db.getStats(Banner::Character);
+	EXPECT_EQ(stats.total, 6);
+	EXPECT_EQ(stats.count5, 2);
+	EXPECT_EQ(stats.pity5, 3);
+	EXPECT_EQ(stats.last5Time, dateToEpoch("2021-01-12 18:37:29"));
+	EXPECT_EQ(db.getStats(Banner::Weapon), wishStats{});
+}
+
+TEST_F(SQLSuite, StatsOfTwoConnections)
+{
+	// both connections cache stats, keys and marks of the same banner
+	SQLDatabase a("sharedStatsTest.db");
+	SQLDatabase b("sharedStatsTest.db");
+	EXPECT_EQ(a.getStats(Banner::Character), wishStats{});
+	EXPECT_EQ(b.getStats(Banner::Character), wishStats{});
+	a.insertWish(Banner::Character, wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5));
+	b.insertWish(Banner::Character, wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3));
+	EXPECT_EQ(a.latestWish(Banner::Character).time, dateToEpoch("2021-01-12 18:39:21"));
+
+	// idempotent import of b sees the wish a stored
+	EXPECT_EQ(b.importWishes(Banner::Character, std::vector<wishEntry>{ wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5) }), 0);
+
+	SQLDatabase fresh("sharedStatsTest.db");
+	wishStats stats = fresh.getStats(Banner::Character);
+	EXPECT_EQ(stats.total, 2);
+	EXPECT_EQ(stats.count5, 1);
+	EXPECT_EQ(stats.pity5, 1);
+	EXPECT_EQ(stats, fresh.Database::getStats(Banner::Character));
+	EXPECT_EQ(a.getStats(Banner::Character), stats);
+}
+
+TEST_F(SQLSuite, UnstorableItemRollsBackBatch)
+{
+	std::string filename = "itemFailTest.db";
+	SQLDatabase db(filename);
+	db.insertWish(Banner::Character, wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5));
+
+	sqlite3* cHandle;
+	ASSERT_EQ(sqlite3_open(filename.c_str(), &cHandle), SQLITE_OK);
+	ASSERT_EQ(sqlite3_exec(cHandle, "CREATE TRIGGER failItem BEFORE INSERT ON items BEGIN SELECT RAISE(ABORT, 'forced'); END;",
+		nullptr, nullptr, nullptr), SQLITE_OK);
+	// first wish has a known item and is written, new item of the second one fails and takes it back
+	size_t inserted;
+	EXPECT_FALSE(db.tryInsertWishes(Banner::Character, std::vector<wishEntry>{
+		wishEntry("Character", "Ganyu", "2021-01-13 10:00:00", 5),
+		wishEntry("Character", "Diluc", "2021-01-13 10:00:00", 5) }, inserted));
+	EXPECT_EQ(inserted, 0);
+	sqlite3_exec(cHandle, "DROP TRIGGER failItem;", nullptr, nullptr, nullptr);
+	sqlite3_close(cHandle);
+
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Character, wishList);
+	EXPECT_EQ(wishList.size(), 1);
+	EXPECT_EQ(db.getStats(Banner::Character).total, 1);
+}
+
+TEST_F(SQLSuite, BackupAndRestore)
+{
+	std::vector<wishEntry> wishList(500, wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3));
+	for (size_t i = 0; i < wishList.size(); i++)
+	{
+		wishList[i].date = epochToDate(dateToEpoch("2021-01-12 18:39:21") + i);
+	}
+
+	SQLDatabase db("backupSource.db");
+	db.insertWishes(Banner::Character, wishList);
+
+	std::vector<backupProgress> progress;
+	ASSERT_TRUE(db.backup("backupCopy.db", 1, [&](const backupProgress &p) { progress.push_back(p); }));
+	ASSERT_GT(progress.size(), 1);
+	EXPECT_EQ(progress.back().pagesDone, progress.back().pagesTotal);
+
+	{
+		SQLDatabase copy("backupCopy.db");
+		std::vector<wishEntry> wishList2;
+		copy.getWishes(Banner::Character, wishList2);
+		EXPECT_EQ(wishList2.size(), wishList.size());
+	}
+
+	// Whatever was written after backup is gone after restore, cached stats too
+	db.insertWish(Banner::Character, wishEntry("Character", "Ganyu", "2021-02-01 10:00:00", 5));
+	EXPECT_EQ(db.getStats(Banner::Character).count5, 1);
+	ASSERT_TRUE(db.restore("backupCopy.db"));
+	EXPECT_EQ(db.getStats(Banner::Character).count5, 0);
+	EXPECT_EQ(db.getStats(Banner::Character).total, wishList.size());
+
+	std::vector<wishEntry> wishList3;
+	db.getWishes(Banner::Character, wishList3);
+	EXPECT_EQ(wishList3.size(), wishList.size());
+
+	EXPECT_FALSE(db.restore("doesNotExist.db"));
+}
+
+TEST_F(SQLSuite, ClusteredLayout)
+{
+	std::string filename = "clusteredTest.db";
+	// later 10-pull is imported first, as with screenshots taken out of order
+	std::vector<wishEntry> later(10, wishEntry("Weapon", "Slingshot", "2021-01-14 10:00:00", 3));
+	std::vector<wishEntry> earlier(10, wishEntry("Weapon", "Raven Bow", "2021-01-12 18:37:29", 3));
+	earlier[9] = wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5);
+	{
+		SQLDatabase db(filename);
+		EXPECT_EQ(db.layout(Banner::Character), wishTableLayout::Rowid);
+		db.insertWishes(Banner::Character, later);
+		db.insertWishes(Banner::Character, earlier);
+		std::vector<wishEntry> wishList;
+		db.getWishes(Banner::Character, wishList);
+		EXPECT_EQ(wishList.front().itemName, "Slingshot") << "Rowid layout returns insertion order";
+		wishStats stats = db.getStats(Banner::Character);
+
+		ASSERT_TRUE(db.setLayout(wishTableLayout::Clustered));
+		for (Banner banner : g_banners)
+		{
+			EXPECT_EQ(db.layout(banner), wishTableLayout::Clustered);
+		}
+		db.getWishes(Banner::Character, wishList);
+		ASSERT_EQ(wishList.size(), 20);
+		EXPECT_EQ(wishList[0].itemName, "Raven Bow");
+		EXPECT_EQ(wishList[9].itemName, "Ganyu");
+		EXPECT_EQ(wishList[10].itemName, "Slingshot");
+		EXPECT_EQ(db.getStats(Banner::Character), stats);
+
+		// inserts go through the primary key, change feed still gets them
+		std::vector<wishBatch> batches;
+		db.subscribe([&](const wishBatch &batch) { batches.push_back(batch); });
+		EXPECT_EQ(db.importWishes(Banner::Character, earlier), 0);
+		std::vector<wishEntry> middle(10, wishEntry("Weapon", "Slingshot", "2021-01-13 10:00:00", 3));
+		EXPECT_EQ(db.importWishes(Banner::Character, middle), 10);
+		ASSERT_EQ(batches.size(), 1);
+		EXPECT_EQ(batches[0].firstRow, -1);
+		EXPECT_EQ(batches[0].wishes.size(), 10);
+
+		std::vector<compactWish> compact;
+		db.getWishes(Banner::Character, compact);
+		EXPECT_TRUE(std::is_sorted(compact.begin(), compact.end(), [](auto &a, auto &b) { return a.time < b.time; }));
+		EXPECT_EQ(db.latestWish(Banner::Character).time, dateToEpoch("2021-01-14 10:00:00"));
+	}
+
+	// layout is read from schema
+	SQLDatabase db(filename);
+	EXPECT_EQ(db.layout(Banner::Weapon), wishTableLayout::Clustered);
+	SQLConnectionPool pool(filename, 2);
+	std::array<std::vector<wishEntry>, g_bannerCount> all;
+	pool.loadAll(all);
+	EXPECT_EQ(all[static_cast<size_t>(Banner::Character)].size(), 30);
+	EXPECT_EQ(all[static_cast<size_t>(Banner::Character)][9].itemName, "Ganyu");
+
+	// and back, rowid table gets ids in time order and its key index again
+	ASSERT_TRUE(db.setLayout(wishTableLayout::Rowid));
+	EXPECT_EQ(SQLDatabase::tableLayout(pool.connection().get(), Banner::Character), wishTableLayout::Rowid);
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Character, wishList);
+	EXPECT_EQ(wishList[9].itemName, "Ganyu");
+	EXPECT_EQ(db.importWishes(Banner::Character, later), 0);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/deltaImport.h"
+#include "../src/memoryDb.h"
+#include "utilityTest.h"
+
+// ---------------------------------------------------------------------
+// DELTA IMPORT TEST
+// ---------------------------------------------------------------------
+
+class DeltaImportSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+
+	// Newest first, as game history shows them
+	std::vector<wishEntry> history = {
+		wishEntry("Character", "Ganyu", "2021-01-14 12:00:00", 5),
+		wishEntry("Weapon", "Slingshot", "2021-01-13 10:00:00", 3),
+		wishEntry("Weapon", "Raven Bow", "2021-01-12 18:39:21", 3),
+		wishEntry("Character", "Xingqiu", "2021-01-12 18:39:21", 4),
+		wishEntry("Weapon", "Skyrider Sword", "2021-01-11 09:00:00", 3) };
+};
+
+TEST_F(DeltaImportSuite, LatestWishIsCachedAndMovedByWrites)
+{
+	SQLDatabase db("deltaImportTest.db");
+	EXPECT_EQ(db.latestWish(Banner::Weapon).time, -1);
+
+	std::vector<wishEntry> oldestFirst(history.rbegin(), history.rend());
+	db.insertWishes(Banner::Weapon, oldestFirst);
+	EXPECT_EQ(db.latestWish(Banner::Weapon), (wishMark{ dateToEpoch("2021-01-14 12:00:00"), 0 }));
+
+	db.insertWish(Banner::Weapon, wishEntry("Weapon", "Slingshot", "2021-01-14 12:00:00", 3));
+	EXPECT_EQ(db.latestWish(Banner::Weapon), (wishMark{ dateToEpoch("2021-01-14 12:00:00"), 1 }));
+
+	// Default implementation has to agree
+	InMemoryDatabase memory;
+	memory.insertWishes(Banner::Weapon, oldestFirst);
+	memory.insertWish(Banner::Weapon, wishEntry("Weapon", "Slingshot", "2021-01-14 12:00:00", 3));
+	EXPECT_EQ(memory.latestWish(Banner::Weapon), db.latestWish(Banner::Weapon));
+}
+
+TEST_F(DeltaImportSuite, StopsAtStoredHistory)
+{
+	SQLDatabase db("deltaImportTest.db");
+	// Week one, history ends with the 10-pull at 18:39:21
+	{
+		DeltaImport import(db, Banner::Standard);
+		for (size_t i = 2; i < history.size(); i++)
+		{
+			EXPECT_TRUE(import.add(history[i]));
+		}
+		EXPECT_EQ(import.commit(), 3);
+	}
+
+	// Week two, whole history is visible again
+	DeltaImport import(db, Banner::Standard);
+	size_t read = 0;
+	for (auto &wish : history)
+	{
+		if (!import.add(wish))
+		{
+			break;
+		}
+		read++;
+	}
+	EXPECT_TRUE(import.done());
+	// two new wishes and the 10-pull at the mark, oldest wish was never looked at
+	EXPECT_EQ(read, 4);
+	EXPECT_EQ(import.commit(), 2);
+
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Standard, wishList);
+	ASSERT_EQ(wishList.size(), history.size());
+	EXPECT_EQ(wishList.front().itemName, "Skyrider Sword");
+	EXPECT_EQ(wishList.back().itemName, "Ganyu");
+}
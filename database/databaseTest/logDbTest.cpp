@@ -0,0 +1,250 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/logDb.h"
+#include "utilityTest.h"
+#include <climits>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+// ---------------------------------------------------------------------
+// LOG DATABASE TEST
+// ---------------------------------------------------------------------
+
+class LogDatabaseSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+
+	void SetUp() override
+	{
+		std::filesystem::remove_all(directory);
+	}
+
+	std::vector<wishEntry> tenPull(const std::string &date)
+	{
+		std::vector<wishEntry> wishes;
+		for (int i = 0; i < 10; i++)
+		{
+			wishes.emplace_back("Weapon", i == 9 ? "Skyward Harp" : "Slingshot", date, i == 9 ? 5 : 3);
+		}
+		return wishes;
+	}
+
+	std::string lastSegment()
+	{
+		std::string last;
+		for (auto &entry : std::filesystem::directory_iterator(directory))
+		{
+			std::string path = entry.path().string();
+			if (path.ends_with(".seg") && path > last)
+			{
+				last = path;
+			}
+		}
+		return last;
+	}
+
+	const std::string directory = "logDbTest";
+};
+
+TEST_F(LogDatabaseSuite, RoundTripAndReopen)
+{
+	std::vector<wishEntry> wishes = tenPull("2021-01-12 18:37:29");
+	wishes.emplace_back("Character", "Ganyu", "2021-01-12 18:40:00", 5);
+	{
+		LogDatabase db(directory);
+		db.insertWishes(Banner::Weapon, wishes);
+		EXPECT_EQ(db.count(Banner::Weapon), 11);
+		EXPECT_EQ(db.count(Banner::Character), 0);
+		EXPECT_EQ(db.latestWish(Banner::Weapon), (wishMark{ dateToEpoch("2021-01-12 18:40:00"), 0 }));
+		EXPECT_EQ(db.latestWish(Banner::Character).time, -1);
+	}
+
+	LogDatabase db(directory);
+	std::vector<wishEntry> stored;
+	db.getWishes(Banner::Weapon, stored);
+	ASSERT_EQ(stored.size(), wishes.size());
+	for (size_t i = 0; i < wishes.size(); i++)
+	{
+		EXPECT_EQ(stored[i].itemName, wishes[i].itemName);
+		EXPECT_EQ(stored[i].itemType, wishes[i].itemType);
+		EXPECT_EQ(stored[i].date, wishes[i].date);
+		EXPECT_EQ(stored[i].itemRarity, wishes[i].itemRarity);
+	}
+	EXPECT_EQ(db.latestWish(Banner::Weapon), (wishMark{ dateToEpoch("2021-01-12 18:40:00"), 0 }));
+
+	// appended wish with a stored time continues its seq
+	db.insertWish(Banner::Weapon, wishEntry("Character", "Ganyu", "2021-01-12 18:40:00", 5));
+	EXPECT_EQ(db.latestWish(Banner::Weapon), (wishMark{ dateToEpoch("2021-01-12 18:40:00"), 1 }));
+
+	// rejected wish doesn't add its item to the dictionary
+	size_t dictionary = std::filesystem::file_size(directory + "/items.dict");
+	db.insertWish(Banner::Weapon, wishEntry("Weapon", "Amos' Bow", "not a date", 5));
+	EXPECT_EQ(db.count(Banner::Weapon), 12);
+	EXPECT_EQ(std::filesystem::file_size(directory + "/items.dict"), dictionary);
+}
+
+TEST_F(LogDatabaseSuite, TornTailIsTruncated)
+{
+	{
+		LogDatabase db(directory);
+		db.insertWishes(Banner::Weapon, tenPull("2021-01-12 18:37:29"));
+	}
+	std::string segment = lastSegment();
+	ASSERT_FALSE(segment.empty());
+	size_t size = std::filesystem::file_size(segment);
+
+	// crash in the middle of an append leaves part of a record
+	{
+		std::ofstream file(segment, std::ios::binary | std::ios::app);
+		file.write("torn", 4);
+	}
+	{
+		LogDatabase db(directory);
+		EXPECT_EQ(db.count(Banner::Weapon), 10);
+		EXPECT_EQ(std::filesystem::file_size(segment), size);
+	}
+
+	// last record that fails its crc is cut off too
+	{
+		std::fstream file(segment, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(static_cast<std::streamoff>(size - sizeof(LogDatabase::logRecord)));
+		file.put('\x7F');
+	}
+	{
+		LogDatabase db(directory);
+		EXPECT_EQ(db.count(Banner::Weapon), 9);
+		EXPECT_EQ(std::filesystem::file_size(segment), size - sizeof(LogDatabase::logRecord));
+
+		// log goes on after the cut
+		db.insertWish(Banner::Weapon, wishEntry("Weapon", "Skyward Harp", "2021-01-13 10:00:00", 5));
+		std::vector<compactWish> stored;
+		db.getWishes(Banner::Weapon, stored);
+		ASSERT_EQ(stored.size(), 10);
+		EXPECT_EQ(stored.back().time, dateToEpoch("2021-01-13 10:00:00"));
+	}
+
+	// bad record followed by good ones is damage, not a torn append, records after it stay
+	{
+		std::fstream file(segment, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(static_cast<std::streamoff>(sizeof(LogDatabase::fileHeader) + 2 * sizeof(LogDatabase::logRecord)));
+		file.put('\x7F');
+	}
+	LogDatabase db(directory);
+	EXPECT_EQ(db.count(Banner::Weapon), 9);
+	EXPECT_EQ(std::filesystem::file_size(segment), size);
+	std::vector<compactWish> stored;
+	db.getWishes(Banner::Weapon, stored);
+	ASSERT_EQ(stored.size(), 9);
+	EXPECT_EQ(stored.back().time, dateToEpoch("2021-01-13 10:00:00"));
+}
+
+TEST_F(LogDatabaseSuite, ImportSkipsStoredWishes)
+{
+	{
+		LogDatabase db(directory);
+		EXPECT_EQ(db.importWishes(Banner::Weapon, tenPull("2021-01-12 18:37:29")), 10);
+	}
+
+	LogDatabase db(directory);
+	EXPECT_EQ(db.importWishes(Banner::Weapon, tenPull("2021-01-12 18:37:29")), 0);
+
+	// overlapping export adds only the new 10-pull
+	std::vector<wishEntry> overlapping = tenPull("2021-01-12 18:37:29");
+	std::vector<wishEntry> next = tenPull("2021-01-14 09:00:00");
+	overlapping.insert(overlapping.end(), next.begin(), next.end());
+	EXPECT_EQ(db.importWishes(Banner::Weapon, overlapping), 10);
+	EXPECT_EQ(db.count(Banner::Weapon), 20);
+	EXPECT_EQ(db.latestWish(Banner::Weapon), (wishMark{ dateToEpoch("2021-01-14 09:00:00"), 9 }));
+}
+
+TEST_F(LogDatabaseSuite, CompactionMergesSegments)
+{
+	size_t segmentBytes = sizeof(LogDatabase::fileHeader) + 10 * sizeof(LogDatabase::logRecord);
+	std::vector<std::string> dates = { "2021-01-15 10:00:00", "2021-01-14 10:00:00", "2021-01-13 10:00:00", "2021-01-12 10:00:00" };
+	{
+		LogDatabase db(directory, segmentBytes, 2);
+		for (auto &date : dates)
+		{
+			db.insertWishes(Banner::Weapon, tenPull(date));
+			EXPECT_LE(db.segmentCount(Banner::Weapon), 2);
+		}
+		EXPECT_EQ(db.count(Banner::Weapon), 40);
+	}
+
+	LogDatabase db(directory, segmentBytes, 2);
+	EXPECT_EQ(db.count(Banner::Weapon), 40);
+	EXPECT_TRUE(db.compact(Banner::Weapon));
+	EXPECT_EQ(db.segmentCount(Banner::Weapon), 0);
+	EXPECT_TRUE(lastSegment().empty());
+
+	// base is in time order, wishes of one 10-pull keep their order
+	std::vector<compactWish> stored;
+	db.getWishes(Banner::Weapon, stored);
+	ASSERT_EQ(stored.size(), 40);
+	EXPECT_TRUE(std::is_sorted(stored.begin(), stored.end(), [](const compactWish &a, const compactWish &b) { return a.time < b.time; }));
+	EXPECT_EQ(stored.front().time, dateToEpoch("2021-01-12 10:00:00"));
+	EXPECT_EQ(stored[9].itemRarity, 5);
+
+	// still knows its seq numbers after compaction
+	EXPECT_EQ(db.importWishes(Banner::Weapon, tenPull("2021-01-13 10:00:00")), 0);
+	db.insertWish(Banner::Weapon, wishEntry("Weapon", "Slingshot", "2021-01-13 10:00:00", 3));
+	EXPECT_EQ(db.count(Banner::Weapon), 41);
+	EXPECT_EQ(db.segmentCount(Banner::Weapon), 1);
+}
+
+TEST_F(LogDatabaseSuite, LeftoversOfCompactionAreRemoved)
+{
+	size_t segmentBytes = sizeof(LogDatabase::fileHeader) + 10 * sizeof(LogDatabase::logRecord);
+	std::string copy;
+	{
+		LogDatabase db(directory, segmentBytes, 8);
+		db.insertWishes(Banner::Weapon, tenPull("2021-01-12 10:00:00"));
+		db.insertWishes(Banner::Weapon, tenPull("2021-01-13 10:00:00"));
+		copy = lastSegment();
+		std::filesystem::copy_file(copy, copy + ".keep");
+		EXPECT_TRUE(db.compact(Banner::Weapon));
+	}
+	// compaction that crashed after the rename, before it deleted the segments
+	std::filesystem::rename(copy + ".keep", copy);
+	{
+		std::ofstream tmp(directory + "/" + bannerTableName(Banner::Weapon) + ".base.tmp", std::ios::binary);
+		tmp.write("partial", 7);
+	}
+
+	LogDatabase db(directory, segmentBytes, 8);
+	EXPECT_EQ(db.count(Banner::Weapon), 20);
+	EXPECT_TRUE(lastSegment().empty());
+	EXPECT_FALSE(std::filesystem::exists(directory + "/" + bannerTableName(Banner::Weapon) + ".base.tmp"));
+}
+
+TEST_F(LogDatabaseSuite, RangeReadSkipsOtherTimes)
+{
+	LogDatabase db(directory);
+	std::vector<compactWish> wishes;
+	std::uint32_t item = StringInterner::getInstance().intern("Slingshot");
+	for (long long i = 0; i < 2000; i++)
+	{
+		wishes.push_back(compactWish{ 1600000000 + i * 60, item, wishItemType::Weapon, 3 });
+	}
+	db.insertWishes(Banner::Weapon, std::span<const compactWish>(wishes));
+
+	std::vector<compactWish> range;
+	db.getWishesInRange(Banner::Weapon, 1600000000 + 500 * 60, 1600000000 + 999 * 60, range);
+	ASSERT_EQ(range.size(), 500);
+	EXPECT_EQ(range.front().time, 1600000000 + 500 * 60);
+	EXPECT_EQ(range.back().time, 1600000000 + 999 * 60);
+	EXPECT_EQ(range.front().itemId, item);
+
+	// 2000 records are 8 blocks, the range lies in blocks 1-3
+	EXPECT_EQ(db.blocksInRange(Banner::Weapon, 0, LLONG_MAX), 8);
+	EXPECT_EQ(db.blocksInRange(Banner::Weapon, 1600000000 + 500 * 60, 1600000000 + 999 * 60), 3);
+
+	db.getWishesInRange(Banner::Weapon, 0, 1599999999, range);
+	EXPECT_TRUE(range.empty());
+	EXPECT_EQ(db.blocksInRange(Banner::Weapon, 0, 1599999999), 0);
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/memoryDb.h"
+#include "utilityTest.h"
+
+// ---------------------------------------------------------------------
+// IN-MEMORY DB TEST
+// ---------------------------------------------------------------------
+
+class MemorySuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+
+	std::vector<wishEntry> wishList = {
+		wishEntry("Weapon", "Skyrider Sword", "2021-01-12 18:37:29", 3),
+		wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5),
+		wishEntry("Weapon", "Raven Bow", "2021-01-12 18:39:21", 3),
+		wishEntry("Character", "Xingqiu", "2021-01-13 10:00:00", 4),
+		wishEntry("Weapon", "Raven Bow", "2021-01-11 09:00:00", 3) };
+};
+
+TEST_F(MemorySuite, InsertAndGetWishes)
+{
+	InMemoryDatabase db;
+	db.insertWishes(Banner::Character, wishList);
+	db.insertWish(Banner::Character, wishEntry("Character", "Diluc", "2021-01-14 12:00:00", 5));
+
+	std::vector<wishEntry> wishList2;
+	db.getWishes(Banner::Character, wishList2);
+	ASSERT_EQ(wishList2.size(), wishList.size() + 1);
+	for (size_t i = 0; i < wishList.size(); i++)
+	{
+		EXPECT_EQ(wishList[i].itemName, wishList2[i].itemName);
+		EXPECT_EQ(wishList[i].date, wishList2[i].date);
+	}
+	EXPECT_EQ(wishList2.back().itemName, "Diluc");
+	EXPECT_EQ(db.count(Banner::Character), 6);
+	EXPECT_EQ(db.count(Banner::Weapon), 0);
+}
+
+TEST_F(MemorySuite, IndexedAndScannedQueriesMatch)
+{
+	InMemoryDatabase indexed(true);
+	InMemoryDatabase scanned(false);
+	indexed.insertWishes(Banner::Weapon, wishList);
+	scanned.insertWishes(Banner::Weapon, wishList);
+
+	std::vector<wishEntry> byItemIndexed, byItemScanned;
+	indexed.getWishesByItem(Banner::Weapon, "Raven Bow", byItemIndexed);
+	scanned.getWishesByItem(Banner::Weapon, "Raven Bow", byItemScanned);
+	EXPECT_EQ(byItemIndexed.size(), 2);
+	EXPECT_EQ(byItemScanned.size(), 2);
+
+	long long from = dateToEpoch("2021-01-11 00:00:00");
+	long long to = dateToEpoch("2021-01-12 23:59:59");
+	std::vector<wishEntry> rangeIndexed, rangeScanned;
+	indexed.getWishesInRange(Banner::Weapon, from, to, rangeIndexed);
+	scanned.getWishesInRange(Banner::Weapon, from, to, rangeScanned);
+	ASSERT_EQ(rangeIndexed.size(), 4);
+	ASSERT_EQ(rangeScanned.size(), 4);
+
+	// index returns rows in time order, out of order insert comes first
+	EXPECT_EQ(rangeIndexed[0].date, "2021-01-11 09:00:00");
+	EXPECT_EQ(rangeIndexed[3].date, "2021-01-12 18:39:21");
+}
+
+TEST_F(MemorySuite, TimeIndexMergesBatches)
+{
+	InMemoryDatabase db(true);
+	db.insertWishes(Banner::Weapon, std::vector<wishEntry>{
+		wishEntry("Weapon", "Slingshot", "2021-01-14 10:00:00", 3),
+		wishEntry("Weapon", "Raven Bow", "2021-01-12 10:00:00", 3) });
+	// older batch in reverse order, same time as a stored wish goes after it
+	db.insertWishes(Banner::Weapon, std::vector<wishEntry>{
+		wishEntry("Weapon", "Debate Club", "2021-01-13 10:00:00", 3),
+		wishEntry("Weapon", "Black Tassel", "2021-01-12 10:00:00", 3),
+		wishEntry("Weapon", "Cool Steel", "2021-01-11 10:00:00", 3) });
+
+	std::vector<wishEntry> range;
+	db.getWishesInRange(Banner::Weapon, 0, dateToEpoch("2021-01-31 00:00:00"), range);
+	std::vector<std::string> names;
+	for (auto &wish : range)
+	{
+		names.push_back(wish.itemName);
+	}
+	EXPECT_EQ(names, (std::vector<std::string>{ "Cool Steel", "Raven Bow", "Black Tassel", "Debate Club", "Slingshot" }));
+}
+
+TEST_F(MemorySuite, SnapshotToSQLDatabase)
+{
+	InMemoryDatabase memory;
+	memory.insertWishes(Banner::Standard, wishList);
+
+	SQLDatabase db("memorySnapshotTest.db");
+	memory.snapshotTo(db);
+
+	std::vector<wishEntry> wishList2;
+	db.getWishes(Banner::Standard, wishList2);
+	ASSERT_EQ(wishList2.size(), wishList.size());
+	for (size_t i = 0; i < wishList.size(); i++)
+	{
+		EXPECT_EQ(wishList[i].itemType, wishList2[i].itemType);
+		EXPECT_EQ(wishList[i].itemName, wishList2[i].itemName);
+		EXPECT_EQ(wishList[i].date, wishList2[i].date);
+		EXPECT_EQ(wishList[i].itemRarity, wishList2[i].itemRarity);
+	}
+}
+
+TEST_F(MemorySuite, MoveInsertAndGetReplacesContents)
+{
+	InMemoryDatabase db;
+	std::vector<wishEntry> moved = wishList;
+	db.insertWishes(Banner::Beginner, std::move(moved));
+	EXPECT_TRUE(moved.empty());
+
+	// getWishes replaces what was in the list instead of appending to it
+	std::vector<wishEntry> wishList2(10, wishEntry("Weapon", "Slingshot", "2021-01-01 00:00:00", 3));
+	db.getWishes(Banner::Beginner, wishList2);
+	ASSERT_EQ(wishList2.size(), wishList.size());
+	EXPECT_EQ(wishList2[1].itemName, "Ganyu");
+}
+
+TEST_F(MemorySuite, DefaultImportSkipsStoredWishes)
+{
+	InMemoryDatabase db;
+	EXPECT_EQ(db.importWishes(Banner::Weapon, wishList), wishList.size());
+	EXPECT_EQ(db.importWishes(Banner::Weapon, wishList), 0);
+	EXPECT_EQ(db.count(Banner::Weapon), wishList.size());
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/db.h"
+#include "../src/connectionPool.h"
+#include "utilityTest.h"
+
+// ---------------------------------------------------------------------
+// SQL FUNCTIONS TEST
+// ---------------------------------------------------------------------
+
+class SqlFunctionsSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+
+protected:
+	void SetUp() override
+	{
+		ASSERT_EQ(sqlite3_open(":memory:", &handle), SQLITE_OK);
+		ASSERT_TRUE(registerWishFunctions(handle));
+	}
+
+	void TearDown() override
+	{
+		sqlite3_close(handle);
+	}
+
+	sqlite3* handle = nullptr;
+};
+
+using values = std::vector<std::string>;
+
+TEST_F(SqlFunctionsSuite, Epoch)
+{
+	EXPECT_EQ(dbTest::column(handle, "SELECT epoch('2020-11-07 14:53:16');"), values{ "1604760796" });
+	EXPECT_EQ(dbTest::column(handle, "SELECT epoch('yesterday');"), values{ "NULL" });
+	EXPECT_EQ(dbTest::column(handle, "SELECT epoch(NULL);"), values{ "NULL" });
+}
+
+TEST_F(SqlFunctionsSuite, PityWindow)
+{
+	sqlite3_exec(handle, "CREATE TABLE w (id integer PRIMARY KEY, r integer);"
+		"INSERT INTO w(r) VALUES (3), (3), (4), (3), (5), (3), (3), (3), (3);", nullptr, nullptr, nullptr);
+
+	EXPECT_EQ(dbTest::column(handle, "SELECT pity(r) OVER (ORDER BY id) FROM w;"), (values{ "1", "2", "3", "4", "0", "1", "2", "3", "4" }));
+	EXPECT_EQ(dbTest::column(handle, "SELECT pity(r, 4) OVER (ORDER BY id) FROM w;"), (values{ "1", "2", "0", "1", "0", "1", "2", "3", "4" }));
+	// 5 star (id 5) leaves the 3 row frame at id 8, from then on every row of the frame counts
+	EXPECT_EQ(dbTest::column(handle, "SELECT pity(r) OVER (ORDER BY id ROWS 2 PRECEDING) FROM w;"),
+		(values{ "1", "2", "3", "3", "0", "1", "2", "3", "3" }));
+	// as aggregate
+	EXPECT_EQ(dbTest::column(handle, "SELECT pity(r, 4) FROM w WHERE id <= 4;"), values{ "1" });
+	EXPECT_EQ(dbTest::column(handle, "SELECT pity(r) FROM w WHERE id > 100;"), values{ "0" });
+}
+
+TEST_F(SqlFunctionsSuite, BannerOfSchedule)
+{
+	EXPECT_EQ(dbTest::column(handle, "SELECT banner_of(1000);"), values{ "NULL" });
+
+	ASSERT_TRUE(setBannerSchedule(handle, {
+		{ Banner::Weapon, 1000, 2000, "Epitome Invocation" },
+		{ Banner::Character, 1000, 2000, "Ballad in Goblets" },
+		{ Banner::Character, 1500, 3000, "Farewell of Snezhnaya" } }));
+
+	EXPECT_EQ(dbTest::column(handle, "SELECT banner_of(999);"), values{ "NULL" });
+	EXPECT_EQ(dbTest::column(handle, "SELECT banner_of(1000, 0);"), values{ "Ballad in Goblets" });
+	EXPECT_EQ(dbTest::column(handle, "SELECT banner_of(1000, 1);"), values{ "Epitome Invocation" });
+	// overlap, latest started wins
+	EXPECT_EQ(dbTest::column(handle, "SELECT banner_of(1700, 0);"), values{ "Farewell of Snezhnaya" });
+	EXPECT_EQ(dbTest::column(handle, "SELECT banner_of(1999, 1);"), values{ "Epitome Invocation" });
+	EXPECT_EQ(dbTest::column(handle, "SELECT banner_of(2000, 1);"), values{ "NULL" });
+	EXPECT_EQ(dbTest::column(handle, "SELECT banner_of('1970-01-01 00:40:00', 0);"), values{ "Farewell of Snezhnaya" });
+
+	// must not be used from schema, view that calls it can't be queried
+	sqlite3_exec(handle, "CREATE TABLE t (time integer); CREATE VIEW v AS SELECT banner_of(time) FROM t;", nullptr, nullptr, nullptr);
+	sqlite3_stmt* stmt = nullptr;
+	EXPECT_NE(sqlite3_prepare_v2(handle, "SELECT * FROM v;", -1, &stmt, NULL), SQLITE_OK);
+	sqlite3_finalize(stmt);
+}
+
+TEST_F(SqlFunctionsSuite, PoolQueriesMatchStats)
+{
+	SQLDatabase db("functionsTest.db");
+	std::vector<wishEntry> wishList;
+	for (int i = 0; i < 30; i++)
+	{
+		wishList.emplace_back("Character", "Xiangling", "2021-01-12 18:39:21", i == 12 ? 5 : (i % 10 == 3 ? 4 : 3));
+	}
+	db.insertWishes(Banner::Character, wishList);
+	wishStats stats = db.getStats(Banner::Character);
+
+	SQLConnectionPool pool("functionsTest.db", 1);
+	pool.setBannerSchedule({
+		{ Banner::Character, dateToEpoch("2021-01-12 18:00:00"), dateToEpoch("2021-02-02 18:00:00"), "Adrift in the Harbor" } });
+	auto conn = pool.connection();
+	ASSERT_TRUE(conn);
+	EXPECT_EQ(dbTest::column(conn.get(), "SELECT pity(itemRarity) OVER (ORDER BY timeReceived, seq) FROM wishCharacter"
+		" ORDER BY timeReceived DESC, seq DESC LIMIT 1;"),
+		values{ std::to_string(stats.pity5) });
+	EXPECT_EQ(dbTest::column(conn.get(), "SELECT DISTINCT banner_of(timeReceived, 0) FROM wishCharacter;"), values{ "Adrift in the Harbor" });
+}
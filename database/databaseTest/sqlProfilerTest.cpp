@@ -0,0 +1,82 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/db.h"
+#include "utilityTest.h"
+#include <algorithm>
+
+// ---------------------------------------------------------------------
+// SQL PROFILER TEST
+// ---------------------------------------------------------------------
+
+class ProfilerSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+};
+
+TEST_F(ProfilerSuite, NormalizeGroupsLiterals)
+{
+	EXPECT_EQ(SQLProfiler::normalize("SELECT *  FROM t\n WHERE id = 5 AND name = 'it''s'"), "SELECT * FROM t WHERE id = ? AND name = ?");
+	EXPECT_EQ(SQLProfiler::normalize("INSERT INTO bannerStats VALUES (0, 12, -1);"), "INSERT INTO bannerStats VALUES (?, ?, -?);");
+	// digits inside identifiers stay
+	EXPECT_EQ(SQLProfiler::normalize("DROP TABLE wishCharacter_v2;"), "DROP TABLE wishCharacter_v2;");
+}
+
+TEST_F(ProfilerSuite, CountsStatementsAndRows)
+{
+	SQLDatabase db("profilerTest.db");
+	db.enableProfiling();
+	ASSERT_NE(db.profiler(), nullptr);
+
+	std::vector<wishEntry> wishList(20, wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3));
+	db.insertWishes(Banner::Weapon, wishList);
+	std::vector<wishEntry> wishList2;
+	db.getWishes(Banner::Weapon, wishList2);
+
+	auto stats = db.profiler()->snapshot();
+	auto insert = std::find_if(stats.begin(), stats.end(), [](auto &s) { return s.sql.starts_with("INSERT INTO wishWeapon"); });
+	ASSERT_NE(insert, stats.end());
+	EXPECT_EQ(insert->count, 20);
+	EXPECT_EQ(insert->rows, 20);
+
+	auto select = std::find_if(stats.begin(), stats.end(), [](auto &s) { return s.sql.starts_with("SELECT items.itemType"); });
+	ASSERT_NE(select, stats.end());
+	EXPECT_EQ(select->count, 1);
+	EXPECT_EQ(select->rows, 20);
+
+	unsigned long long histogramTotal = 0;
+	for (auto count : insert->histogram)
+	{
+		histogramTotal += count;
+	}
+	EXPECT_EQ(histogramTotal, insert->count);
+	EXPECT_TRUE(std::is_sorted(stats.begin(), stats.end(), [](auto &a, auto &b) { return a.totalNs > b.totalNs; }));
+}
+
+TEST_F(ProfilerSuite, DdlAndFastStatements)
+{
+	sqlite3* handle;
+	ASSERT_EQ(sqlite3_open(":memory:", &handle), SQLITE_OK);
+	{
+		SQLProfiler profiler;
+		profiler.attach(handle);
+		sqlite3_exec(handle, "CREATE TABLE t (x INTEGER);", nullptr, nullptr, nullptr);
+		sqlite3_exec(handle, "INSERT INTO t VALUES (1), (2);", nullptr, nullptr, nullptr);
+		// changes of the INSERT are still reported by sqlite3_changes, they don't belong to these
+		sqlite3_exec(handle, "CREATE INDEX tx ON t (x);", nullptr, nullptr, nullptr);
+		sqlite3_exec(handle, "UPDATE t SET x = 3 WHERE x > 5;", nullptr, nullptr, nullptr);
+
+		auto stats = profiler.snapshot();
+		ASSERT_EQ(stats.size(), 4);
+		for (auto &statement : stats)
+		{
+			// microsecond statements are timed, not rounded down to 0
+			EXPECT_GT(statement.totalNs, 0) << statement.sql;
+			EXPECT_EQ(statement.rows, statement.sql.starts_with("INSERT") ? 2 : 0) << statement.sql;
+		}
+	}
+	sqlite3_close(handle);
+}
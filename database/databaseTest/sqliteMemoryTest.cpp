@@ -0,0 +1,80 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/db.h"
+#include "../src/sqliteMemory.h"
+#include "utilityTest.h"
+#include <climits>
+
+// ---------------------------------------------------------------------
+// SQLITE MEMORY CONFIGURATION TEST
+// ---------------------------------------------------------------------
+
+class SqliteMemorySuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+
+	// Other suites get sqlite with default allocator back
+	static void TearDownTestSuite()
+	{
+		configureSqliteMemory(sqliteMemoryConfig{});
+	}
+};
+
+TEST_F(SqliteMemorySuite, PageCacheSlotsAndStats)
+{
+	sqliteMemoryConfig config;
+	config.pageCacheSlots = 64;
+	ASSERT_TRUE(configureSqliteMemory(config));
+
+	{
+		SQLDatabase db("memoryConfigTest.db");
+		std::vector<wishEntry> wishList(2000, wishEntry("Weapon", "Slingshot", "2021-01-12 18:39:21", 3));
+		db.insertWishes(Banner::Weapon, wishList);
+
+		sqliteMemoryStats stats = getSqliteMemoryStats();
+		EXPECT_GT(stats.memoryUsed, 0);
+		EXPECT_GE(stats.memoryUsedPeak, stats.memoryUsed);
+		EXPECT_GT(stats.pageCacheSlotsUsedPeak, 0);
+		EXPECT_LE(stats.pageCacheSlotsUsedPeak, config.pageCacheSlots);
+		logSqliteMemoryStats();
+	}
+}
+
+TEST_F(SqliteMemorySuite, HeapNeedsMemsys5)
+{
+	sqliteMemoryConfig config;
+	config.heapBytes = 8 << 20;
+	bool memsys5 = sqlite3_compileoption_used("ENABLE_MEMSYS5");
+	EXPECT_EQ(configureSqliteMemory(config), memsys5);
+
+	// sqlite works either way, with the heap or with malloc it fell back to
+	SQLDatabase db("memoryConfigTest.db");
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Weapon, wishList);
+	EXPECT_EQ(wishList.size(), 2000);
+	if (memsys5)
+	{
+		EXPECT_LE(getSqliteMemoryStats().memoryUsedPeak, config.heapBytes);
+	}
+}
+
+TEST_F(SqliteMemorySuite, SizesHaveToFitInInt)
+{
+	// refused before anything is allocated, sqlite goes on with malloc and default page cache
+	sqliteMemoryConfig config;
+	config.heapBytes = static_cast<size_t>(INT_MAX) + 1;
+	EXPECT_FALSE(configureSqliteMemory(config));
+
+	config = sqliteMemoryConfig{};
+	config.pageCacheSlots = INT_MAX / 4096;
+	EXPECT_FALSE(configureSqliteMemory(config));
+
+	SQLDatabase db("memoryConfigTest.db");
+	std::vector<wishEntry> wishList;
+	db.getWishes(Banner::Weapon, wishList);
+	EXPECT_EQ(wishList.size(), 2000);
+}
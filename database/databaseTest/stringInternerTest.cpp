@@ -0,0 +1,49 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/stringInterner.h"
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// STRING INTERNER TEST
+// ---------------------------------------------------------------------
+
+TEST(InternerSuite, InternAndFind)
+{
+	StringInterner interner;
+	std::uint32_t ganyu = interner.intern("Ganyu");
+	std::uint32_t diluc = interner.intern("Diluc");
+
+	EXPECT_NE(ganyu, diluc);
+	EXPECT_EQ(interner.intern("Ganyu"), ganyu);
+	EXPECT_EQ(interner.find("Diluc"), diluc);
+	EXPECT_EQ(interner.find("Keqing"), StringInterner::npos);
+	EXPECT_EQ(interner.name(ganyu), "Ganyu");
+	EXPECT_EQ(interner.size(), 2);
+}
+
+TEST(InternerSuite, ConcurrentInternGivesSameIds)
+{
+	StringInterner interner;
+	std::vector<std::vector<std::uint32_t>> ids(4);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < ids.size(); t++)
+	{
+		threads.emplace_back([&, t] {
+			for (int i = 0; i < 200; i++)
+			{
+				ids[t].push_back(interner.intern("item_" + std::to_string(i)));
+			}
+		});
+	}
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_EQ(interner.size(), 200);
+	for (size_t t = 1; t < ids.size(); t++)
+	{
+		EXPECT_EQ(ids[t], ids[0]);
+	}
+}
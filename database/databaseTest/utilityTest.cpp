@@ -1,3 +1,5 @@
+#include <gtest/gtest.h> // googletest header file
+
 #include "utilityTest.h"
 #include <filesystem>
 
@@ -33,19 +35,96 @@ int dbTest::getVersion(sqlite3* cHandle)
 	return version;
 }
 
+int dbTest::getUserVersion(sqlite3* cHandle)
+{
+	sqlite3_stmt* stmt;
+	int rc = sqlite3_prepare_v2(cHandle, "PRAGMA user_version;", -1, &stmt, NULL);
+	int version = 0;
+
+	if ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+		version = sqlite3_column_int(stmt, 0);
+	}
+	sqlite3_finalize(stmt);
+	return version;
+}
+
+// Creates database the way version 1 of the app did, with given wishes in wishCharacter table
+void dbTest::createV1Db(std::string filename, const std::vector<wishEntry> &wishes)
+{
+	sqlite3* cHandle;
+	sqlite3_open(filename.c_str(), &cHandle);
+
+	std::vector<std::string> commands = { "BEGIN;",
+		"CREATE TABLE systemInfo (creationDate date DEFAULT CURRENT_TIMESTAMP, version integer NOT NULL PRIMARY KEY);",
+		"INSERT INTO systemInfo (version) VALUES (1);" };
+	for (auto table : { "wishCharacter", "wishWeapon", "wishStandard", "wishBeginner" })
+	{
+		commands.push_back(std::string("CREATE TABLE ") + table + "(id integer PRIMARY KEY AUTOINCREMENT, itemType text"
+			" NOT NULL, itemName text NOT NULL, timeReceived date NOT NULL, itemRarity integer NOT NULL);");
+	}
+	for (auto &wish : wishes)
+	{
+		commands.push_back("INSERT INTO wishCharacter(itemType, itemName, timeReceived, itemRarity) VALUES(\"" +
+			wish.itemType + "\",\"" + wish.itemName + "\",\"" + wish.date + "\"," + std::to_string(wish.itemRarity) + ");");
+	}
+	commands.push_back("COMMIT;");
+
+	for (auto &command : commands)
+	{
+		sqlite3_exec(cHandle, command.c_str(), NULL, 0, NULL);
+	}
+	sqlite3_close(cHandle);
+}
+
 void dbTest::removeDbFiles()
 {
-	std::vector<std::string> dbNames = { g_filename, "customName.db" };
+	std::vector<std::string> dbNames = { g_filename, "customName.db", "asyncTest.db", "asyncFailTest.db", "asyncFailWishTest.db", "asyncInvalidDateTest.db", "poolTest.db", "upgradeTest.db", "failedUpgradeTest.db", "badDateUpgradeTest.db", "memorySnapshotTest.db", "compactTest.db", "importTest.db", "deltaImportTest.db", "statsTest.db", "sharedStatsTest.db", "itemFailTest.db", "backupSource.db", "backupCopy.db", "profilerTest.db", "memoryConfigTest.db", "functionsTest.db", "columnsTableTest.db", "changeFeedTest.db", "poolLoadAllTest.db", "clusteredTest.db", "snapshotTest.db", "snapshotTest.gwv", "transferTest.db", "transferFailTest.db", "transferTest.csv", "transferTest.jsonl" };
 	for (auto& db : dbNames)
 	{
-		auto path = std::filesystem::path(db);
-		if (std::filesystem::exists(path))
-		{
-			std::filesystem::remove(path);
-		}
-		else
+		// WAL mode leaves -wal and -shm files next to the database
+		for (auto& suffix : { "", "-wal", "-shm" })
 		{
-			// Doesn't exist
+			auto path = std::filesystem::path(db + suffix);
+			if (std::filesystem::exists(path))
+			{
+				std::filesystem::remove(path);
+			}
+			else
+			{
+				// Doesn't exist
+			}
 		}
 	}
+
+	// LogDatabase keeps its files in a directory
+	for (auto& directory : { "logDbTest" })
+	{
+		std::filesystem::remove_all(directory);
+	}
+}
+
+static void appendText(std::vector<std::string> &values, sqlite3_stmt* row)
+{
+	const unsigned char* text = sqlite3_column_text(row, 0);
+	values.emplace_back(text ? reinterpret_cast<const char*>(text) : "NULL");
+}
+
+std::vector<std::string> dbTest::column(sqlite3* cHandle, const std::string &sql)
+{
+	std::vector<std::string> values;
+	sqlite3_stmt* stmt;
+	EXPECT_EQ(sqlite3_prepare_v2(cHandle, sql.c_str(), -1, &stmt, NULL), SQLITE_OK) << sqlite3_errmsg(cHandle);
+	while (sqlite3_step(stmt) == SQLITE_ROW)
+	{
+		appendText(values, stmt);
+	}
+	sqlite3_finalize(stmt);
+	return values;
+}
+
+std::vector<std::string> dbTest::column(SQLDatabase &db, const std::string &sql)
+{
+	std::vector<std::string> values;
+	EXPECT_TRUE(db.query(sql, [&](sqlite3_stmt* row) { appendText(values, row); })) << sql;
+	return values;
 }
@@ -2,14 +2,19 @@
 #define DATABASE_UTILITY_TEST_H
 
 #include "../src/db.h"
-#include "../src/sqlite3.h"
+#include <sqlite3.h>
 #include <unordered_set>
 
 namespace dbTest
 {
 	void getTables(sqlite3* cHandle, std::unordered_set<std::string> &tables);
 	int getVersion(sqlite3* cHandle);
+	int getUserVersion(sqlite3* cHandle);
+	void createV1Db(std::string filename, const std::vector<wishEntry> &wishes);
 	void removeDbFiles();
+	// First column of every row as text, NULL becomes "NULL"
+	std::vector<std::string> column(sqlite3* cHandle, const std::string &sql);
+	std::vector<std::string> column(SQLDatabase &db, const std::string &sql);
 }
 
 #endif /* DATABASE_UTILITY_TEST_H */
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/db.h"
+#include "../src/wishColumns.h"
+#include "utilityTest.h"
+
+// ---------------------------------------------------------------------
+// WISH COLUMNS VIRTUAL TABLE TEST
+// ---------------------------------------------------------------------
+
+class ColumnsTableSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+
+	std::vector<wishEntry> wishList = {
+		wishEntry("Weapon", "Slingshot", "2021-01-12 18:37:29", 3),
+		wishEntry("Weapon", "Raven Bow", "2021-01-12 18:37:29", 3),
+		wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5),
+		wishEntry("Weapon", "Slingshot", "2021-01-13 10:00:00", 3),
+		wishEntry("Character", "Xingqiu", "2021-01-13 10:00:00", 4),
+		wishEntry("Weapon", "Raven Bow", "2021-01-14 10:00:00", 3),
+		wishEntry("Weapon", "Slingshot", "2021-01-14 10:00:00", 3) };
+};
+
+using values = std::vector<std::string>;
+
+TEST_F(ColumnsTableSuite, TimeAndRarityConstraints)
+{
+	SQLDatabase db("columnsTableTest.db");
+	WishColumns columns;
+	columns.load(wishList);
+	ASSERT_TRUE(columns.timeOrdered());
+	ASSERT_TRUE(db.attachColumns("pending", columns));
+
+	EXPECT_EQ(dbTest::column(db, "SELECT count(*) FROM pending;"), values{ "7" });
+	EXPECT_EQ(dbTest::column(db, "SELECT itemName FROM pending WHERE rarity >= 4;"), (values{ "Ganyu", "Xingqiu" }));
+	EXPECT_EQ(dbTest::column(db, "SELECT itemName || ' ' || itemType FROM pending WHERE time >= epoch('2021-01-13 00:00:00')"
+		" AND time < epoch('2021-01-14 00:00:00');"), (values{ "Slingshot Weapon", "Xingqiu Character" }));
+	EXPECT_EQ(dbTest::column(db, "SELECT rowid FROM pending WHERE time = epoch('2021-01-14 10:00:00') AND rarity = 3;"), (values{ "5", "6" }));
+	EXPECT_EQ(dbTest::column(db, "SELECT pity(rarity) OVER (ORDER BY rowid) FROM pending WHERE rarity < 5 ORDER BY rowid DESC LIMIT 1;"), values{ "6" });
+
+	// values that aren't integers follow sqlite comparison rules
+	EXPECT_EQ(dbTest::column(db, "SELECT count(*) FROM pending WHERE rarity = 3.5;"), values{ "0" });
+	EXPECT_EQ(dbTest::column(db, "SELECT count(*) FROM pending WHERE rarity > 3.5;"), values{ "2" });
+	EXPECT_EQ(dbTest::column(db, "SELECT count(*) FROM pending WHERE rarity <= '4';"), values{ "6" });
+	EXPECT_EQ(dbTest::column(db, "SELECT count(*) FROM pending WHERE time < 'later';"), values{ "7" });
+	EXPECT_EQ(dbTest::column(db, "SELECT count(*) FROM pending WHERE time > 'later';"), values{ "0" });
+	EXPECT_EQ(dbTest::column(db, "SELECT count(*) FROM pending WHERE time = NULL;"), values{ "0" });
+
+	// constraints are handed to the table
+	std::string plan;
+	db.query("EXPLAIN QUERY PLAN SELECT * FROM pending WHERE time >= 5 AND rarity = 5;", [&](sqlite3_stmt* row) {
+		plan += reinterpret_cast<const char*>(sqlite3_column_text(row, 3));
+	});
+	EXPECT_NE(plan.find("VIRTUAL TABLE INDEX 0:tgr="), std::string::npos) << plan;
+
+	ASSERT_TRUE(db.detachColumns("pending"));
+	EXPECT_FALSE(db.query("SELECT count(*) FROM pending;", [](sqlite3_stmt*) {}));
+}
+
+TEST_F(ColumnsTableSuite, UnorderedTimesAreScanned)
+{
+	SQLDatabase db("columnsTableTest.db");
+	WishColumns columns;
+	std::vector<wishEntry> newestFirst(wishList.rbegin(), wishList.rend());
+	columns.load(newestFirst);
+	ASSERT_FALSE(columns.timeOrdered());
+	ASSERT_TRUE(db.attachColumns("pending", columns));
+
+	EXPECT_EQ(dbTest::column(db, "SELECT itemName FROM pending WHERE time BETWEEN epoch('2021-01-13 00:00:00') AND epoch('2021-01-13 23:59:59');"),
+		(values{ "Xingqiu", "Slingshot" }));
+	EXPECT_EQ(dbTest::column(db, "SELECT itemName FROM pending ORDER BY time, rowid LIMIT 1;"), values{ "Ganyu" });
+
+	// columns are read when queried, appended wish shows up
+	columns.append(wishEntry("Character", "Keqing", "2021-01-20 10:00:00", 5));
+	EXPECT_EQ(dbTest::column(db, "SELECT itemName FROM pending WHERE rarity = 5 ORDER BY time DESC;"), (values{ "Keqing", "Ganyu" }));
+}
+
+TEST_F(ColumnsTableSuite, QueryIsReadOnly)
+{
+	SQLDatabase db("columnsTableTest.db");
+	EXPECT_FALSE(db.query("DELETE FROM wishCharacter;", [](sqlite3_stmt*) {}));
+	EXPECT_FALSE(db.query("SELECT * FROM missingTable;", [](sqlite3_stmt*) {}));
+}
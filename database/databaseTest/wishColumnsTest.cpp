@@ -0,0 +1,65 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/wishColumns.h"
+#include "../src/memoryDb.h"
+#include "utilityTest.h"
+
+// ---------------------------------------------------------------------
+// WISH COLUMNS TEST
+// ---------------------------------------------------------------------
+
+class ColumnsSuite : public ::testing::Test
+{
+public:
+	// 5 star after 3 pulls, 4 star on 5th pull, then 2 more 3 stars
+	std::vector<wishEntry> wishList = {
+		wishEntry("Weapon", "Slingshot", "2021-01-12 18:37:29", 3),
+		wishEntry("Weapon", "Raven Bow", "2021-01-12 18:37:29", 3),
+		wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5),
+		wishEntry("Weapon", "Slingshot", "2021-01-13 10:00:00", 3),
+		wishEntry("Character", "Xingqiu", "2021-01-13 10:00:00", 4),
+		wishEntry("Weapon", "Raven Bow", "2021-01-14 10:00:00", 3),
+		wishEntry("Weapon", "Slingshot", "2021-01-14 10:00:00", 3) };
+};
+
+TEST_F(ColumnsSuite, LoadFromDatabaseCursor)
+{
+	InMemoryDatabase db;
+	db.insertWishes(Banner::Character, wishList);
+
+	WishColumns columns;
+	columns.load(db, Banner::Character);
+	ASSERT_EQ(columns.size(), wishList.size());
+	EXPECT_EQ(columns.itemIds()[0], columns.itemIds()[3]) << "Same item name should share id";
+	EXPECT_EQ(columns.itemName(columns.itemIds()[2]), "Ganyu");
+
+	for (size_t i = 0; i < wishList.size(); i++)
+	{
+		wishEntry wish = columns.row(i);
+		EXPECT_EQ(wish.itemType, wishList[i].itemType);
+		EXPECT_EQ(wish.itemName, wishList[i].itemName);
+		EXPECT_EQ(wish.date, wishList[i].date);
+		EXPECT_EQ(wish.itemRarity, wishList[i].itemRarity);
+	}
+}
+
+TEST_F(ColumnsSuite, Aggregations)
+{
+	WishColumns columns;
+	columns.load(wishList);
+
+	auto counts = columns.countByRarity();
+	EXPECT_EQ(counts[3], 5);
+	EXPECT_EQ(counts[4], 1);
+	EXPECT_EQ(counts[5], 1);
+
+	EXPECT_EQ(columns.currentPity(5), 4);
+	EXPECT_EQ(columns.currentPity(4), 2);
+	EXPECT_EQ(columns.pityHistory(5), std::vector<unsigned int>({ 3 }));
+	EXPECT_EQ(columns.pityHistory(4), std::vector<unsigned int>({ 3, 2 }));
+
+	auto perDay = columns.countPerBucket(dateToEpoch("2021-01-12 00:00:00"), 86400, 3);
+	EXPECT_EQ(perDay, std::vector<size_t>({ 3, 2, 2 }));
+	auto rarePerDay = columns.countPerBucket(dateToEpoch("2021-01-12 00:00:00"), 86400, 3, 4);
+	EXPECT_EQ(rarePerDay, std::vector<size_t>({ 1, 1, 0 }));
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/memoryDb.h"
+#include "../src/wishSnapshot.h"
+#include "utilityTest.h"
+#include <filesystem>
+#include <fstream>
+
+// ---------------------------------------------------------------------
+// WISH SNAPSHOT TEST
+// ---------------------------------------------------------------------
+
+class WishSnapshotSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+
+	const std::string filename = "snapshotTest.gwv";
+};
+
+TEST_F(WishSnapshotSuite, ExportsEveryBanner)
+{
+	SQLDatabase db("snapshotTest.db");
+	db.insertWishes(Banner::Character, std::vector<wishEntry>{
+		wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5),
+		wishEntry("Weapon", "Slingshot", "2021-01-12 18:37:29", 3),
+		wishEntry("Character", "Xiangling", "2021-01-13 10:00:00", 4) });
+	db.insertWish(Banner::Weapon, wishEntry("Weapon", "Slingshot", "2021-01-14 10:00:00", 3));
+	ASSERT_TRUE(writeSnapshot(filename, db));
+
+	WishSnapshot snapshot;
+	ASSERT_TRUE(snapshot.open(filename));
+	EXPECT_EQ(snapshot.rows(Banner::Character), 3);
+	EXPECT_EQ(snapshot.rows(Banner::Weapon), 1);
+	EXPECT_EQ(snapshot.rows(Banner::Standard), 0);
+	EXPECT_TRUE(snapshot.times(Banner::Beginner).empty());
+	// names are stored once for all banners
+	EXPECT_EQ(snapshot.itemCount(), 3);
+
+	std::vector<wishEntry> stored;
+	db.getWishes(Banner::Character, stored);
+	for (size_t i = 0; i < stored.size(); i++)
+	{
+		wishEntry wish = snapshot.row(Banner::Character, i);
+		EXPECT_EQ(wish.itemName, stored[i].itemName);
+		EXPECT_EQ(wish.itemType, stored[i].itemType);
+		EXPECT_EQ(wish.date, stored[i].date);
+		EXPECT_EQ(wish.itemRarity, stored[i].itemRarity);
+	}
+	EXPECT_EQ(snapshot.itemName(snapshot.items(Banner::Weapon)[0]), "Slingshot");
+	EXPECT_EQ(snapshot.itemName(100), "");
+	EXPECT_EQ(snapshot.rarities(Banner::Character)[0], 5);
+	EXPECT_EQ(snapshot.types(Banner::Character)[1], static_cast<std::uint8_t>(wishItemType::Weapon));
+	EXPECT_TRUE(snapshot.timeOrdered(Banner::Character));
+
+	// exporting again replaces the file (after it's closed, Windows can't replace mapped file)
+	snapshot.close();
+	db.insertWish(Banner::Weapon, wishEntry("Weapon", "Skyward Harp", "2021-01-15 10:00:00", 5));
+	ASSERT_TRUE(writeSnapshot(filename, db));
+	ASSERT_TRUE(snapshot.open(filename));
+	EXPECT_EQ(snapshot.rows(Banner::Weapon), 2);
+	EXPECT_FALSE(std::filesystem::exists(filename + ".tmp"));
+}
+
+TEST_F(WishSnapshotSuite, RangeUsesBlocks)
+{
+	InMemoryDatabase db;
+	std::vector<compactWish> wishes;
+	std::uint32_t item = StringInterner::getInstance().intern("Slingshot");
+	for (long long i = 0; i < 3000; i++)
+	{
+		wishes.push_back(compactWish{ 1600000000 + i * 60, item, wishItemType::Weapon, 3 });
+	}
+	db.insertWishes(Banner::Standard, std::span<const compactWish>(wishes));
+	ASSERT_TRUE(writeSnapshot(filename, db));
+
+	WishSnapshot snapshot;
+	ASSERT_TRUE(snapshot.open(filename));
+	ASSERT_EQ(snapshot.blocks(Banner::Standard).size(), 3);
+	EXPECT_EQ(snapshot.blocks(Banner::Standard)[1].minTime, 1600000000 + 1024 * 60);
+	EXPECT_EQ(snapshot.blocks(Banner::Standard)[2].maxTime, 1600000000 + 2999 * 60);
+
+	long long from = 1600000000 + 500 * 60;
+	long long to = 1600000000 + 2499 * 60;
+	EXPECT_EQ(snapshot.countInRange(Banner::Standard, from, to), 2000);
+	EXPECT_EQ(snapshot.rowsInRange(Banner::Standard, from, to), (std::pair<size_t, size_t>(500, 2500)));
+	EXPECT_EQ(snapshot.countInRange(Banner::Standard, 0, 1599999999), 0);
+}
+
+TEST_F(WishSnapshotSuite, DamagedFileIsRejected)
+{
+	InMemoryDatabase db;
+	db.insertWish(Banner::Character, wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5));
+	ASSERT_TRUE(writeSnapshot(filename, db));
+	size_t size = std::filesystem::file_size(filename);
+
+	// directory is covered by crc
+	{
+		std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(sizeof(WishSnapshot::fileHeader));
+		file.put('\x7F');
+	}
+	WishSnapshot snapshot;
+	EXPECT_FALSE(snapshot.open(filename));
+	EXPECT_FALSE(snapshot.isOpen());
+	EXPECT_EQ(snapshot.rows(Banner::Character), 0);
+
+	ASSERT_TRUE(writeSnapshot(filename, db));
+	std::filesystem::resize_file(filename, size - 1);
+	EXPECT_FALSE(snapshot.open(filename));
+
+	{
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file << "SQLite format 3";
+	}
+	EXPECT_FALSE(snapshot.open(filename));
+}
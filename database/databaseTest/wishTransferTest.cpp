@@ -0,0 +1,226 @@
+#include <gtest/gtest.h> // googletest header file
+
+#include "../src/memoryDb.h"
+#include "../src/wishTransfer.h"
+#include "utilityTest.h"
+#include <filesystem>
+#include <fstream>
+
+// ---------------------------------------------------------------------
+// WISH TRANSFER TEST
+// ---------------------------------------------------------------------
+
+class WishTransferSuite : public ::testing::Test
+{
+public:
+	static void SetUpTestSuite()
+	{
+		dbTest::removeDbFiles();
+	}
+
+	void fill(Database &db)
+	{
+		db.insertWishes(Banner::Character, std::vector<wishEntry>{
+			wishEntry("Character", "Ganyu", "2021-01-12 18:37:29", 5),
+			wishEntry("Weapon", "Mistsplitter, Reforged", "2021-01-12 18:37:29", 5),
+			wishEntry("Weapon", "The \"Catch\"", "2021-01-12 18:37:29", 4),
+			wishEntry("Character", "神里綾華", "2021-01-13 10:00:00", 5) });
+		db.insertWish(Banner::Weapon, wishEntry("Weapon", "Back\\slash\nand tab\t", "2021-01-14 10:00:00", 3));
+	}
+
+	void expectSame(Database &expected, Database &actual)
+	{
+		for (Banner banner : g_banners)
+		{
+			std::vector<wishEntry> a, b;
+			expected.getWishes(banner, a);
+			actual.getWishes(banner, b);
+			ASSERT_EQ(a.size(), b.size());
+			for (size_t i = 0; i < a.size(); i++)
+			{
+				EXPECT_EQ(a[i].itemName, b[i].itemName);
+				EXPECT_EQ(a[i].itemType, b[i].itemType);
+				EXPECT_EQ(a[i].date, b[i].date);
+				EXPECT_EQ(a[i].itemRarity, b[i].itemRarity);
+			}
+		}
+	}
+
+	void writeFile(const std::string &path, const std::string &content)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file << content;
+	}
+};
+
+TEST_F(WishTransferSuite, CsvRoundTrip)
+{
+	SQLDatabase db("transferTest.db");
+	fill(db);
+
+	transferStats stats;
+	ASSERT_TRUE(exportHistory(db, "transferTest.csv", transferFormat::Csv, &stats));
+	EXPECT_EQ(stats.rows, 5);
+	EXPECT_EQ(stats.bytes, std::filesystem::file_size("transferTest.csv"));
+
+	InMemoryDatabase copy;
+	ASSERT_TRUE(importHistory(copy, "transferTest.csv", transferFormat::Csv, false, &stats));
+	EXPECT_EQ(stats.rows, 5);
+	EXPECT_EQ(stats.inserted, 5);
+	EXPECT_EQ(stats.rejected, 0);
+	expectSame(db, copy);
+
+	// same file again adds nothing to the db it came from
+	ASSERT_TRUE(importHistory(db, "transferTest.csv", transferFormat::Csv, true, &stats));
+	EXPECT_EQ(stats.rows, 5);
+	EXPECT_EQ(stats.inserted, 0);
+}
+
+TEST_F(WishTransferSuite, JsonLinesRoundTrip)
+{
+	InMemoryDatabase db;
+	fill(db);
+
+	ASSERT_TRUE(exportHistory(db, "transferTest.jsonl", transferFormat::JsonLines));
+	InMemoryDatabase copy;
+	transferStats stats;
+	ASSERT_TRUE(importHistory(copy, "transferTest.jsonl", transferFormat::JsonLines, true, &stats));
+	EXPECT_EQ(stats.inserted, 5);
+	EXPECT_EQ(stats.rejected, 0);
+	expectSame(db, copy);
+
+	ASSERT_TRUE(importHistory(copy, "transferTest.jsonl", transferFormat::JsonLines, true, &stats));
+	EXPECT_EQ(stats.inserted, 0);
+}
+
+TEST_F(WishTransferSuite, ReadsFilesOfOtherTrackers)
+{
+	// own column order, extra column, CRLF, byte order mark, epoch time, record without newline at the end
+	writeFile("transferTest.csv", "\xEF\xBB\xBFrarity,itemName,time,note,banner,itemType\r\n"
+		"5,Ganyu,2021-01-12 18:37:29,first,Character,Character\r\n"
+		"3,\"Slingshot\",1610476649,\"multi\nline\",Character,Weapon\r\n"
+		"4,Xiangling,2021-01-12 18:37:29,,Event,Character\r\n"
+		"4,Xiangling,not a date,,Character,Character\r\n"
+		"4,\"Fischl\"x,2021-01-12 18:37:29,,Character,Character\r\n"
+		"4,Fischl,2021-01-13 10:00:00,,Character,Character");
+	InMemoryDatabase db;
+	transferStats stats;
+	ASSERT_TRUE(importHistory(db, "transferTest.csv", transferFormat::Csv, false, &stats));
+	EXPECT_EQ(stats.rows, 3);
+	EXPECT_EQ(stats.inserted, 3);
+	EXPECT_EQ(stats.rejected, 3);
+
+	std::vector<wishEntry> wishes;
+	db.getWishes(Banner::Character, wishes);
+	ASSERT_EQ(wishes.size(), 3);
+	EXPECT_EQ(wishes[1].itemName, "Slingshot");
+	EXPECT_EQ(wishes[1].itemType, "Weapon");
+	EXPECT_EQ(wishes[1].date, epochToDate(1610476649));
+	EXPECT_EQ(wishes[2].itemName, "Fischl");
+
+	// whitespace, keys in any order, escapes, unknown keys, epoch time
+	writeFile("transferTest.jsonl",
+		"{ \"itemName\" : \"Caf\\u00e9 \\ud83c\\udf1f\", \"banner\":\"Weapon\", \"time\":1610476649, \"rarity\":4, \"itemType\":\"Weapon\", \"wish\":null, \"new\":true }\n"
+		"\n"
+		"{\"banner\":\"Weapon\",\"time\":\"2021-01-13 10:00:00\",\"itemType\":\"Weapon\",\"itemName\":\"Slingshot\",\"rarity\":3,\"tags\":[]}\n"
+		"{\"banner\":\"Weapon\",\"time\":\"2021-01-13 10:00:00\",\"itemName\":\"Slingshot\"\n"
+		"{\"banner\":\"Weapon\",\"time\":\"2021-01-14 10:00:00\",\"itemType\":\"Weapon\",\"itemName\":\"Slingshot\",\"rarity\":3}");
+	ASSERT_TRUE(importHistory(db, "transferTest.jsonl", transferFormat::JsonLines, false, &stats));
+	EXPECT_EQ(stats.rows, 2);
+	EXPECT_EQ(stats.rejected, 2);
+	db.getWishes(Banner::Weapon, wishes);
+	ASSERT_EQ(wishes.size(), 2);
+	EXPECT_EQ(wishes[0].itemName, "Caf\xC3\xA9 \xF0\x9F\x8C\x9F");
+	EXPECT_EQ(wishes[0].itemRarity, 4);
+	EXPECT_EQ(wishes[1].date, "2021-01-14 10:00:00");
+
+	// header has to name every column
+	writeFile("transferTest.csv", "banner,time,itemName\nCharacter,2021-01-12 18:37:29,Ganyu\n");
+	EXPECT_FALSE(importHistory(db, "transferTest.csv", transferFormat::Csv, false));
+	EXPECT_FALSE(importHistory(db, "missing.csv", transferFormat::Csv, false));
+}
+
+TEST_F(WishTransferSuite, StreamsManyChunks)
+{
+	// several MiB, so records cross chunk boundaries and imports are split into batches
+	InMemoryDatabase db;
+	std::vector<compactWish> wishes;
+	StringInterner &interner = StringInterner::getInstance();
+	std::uint32_t common = interner.intern("Slingshot");
+	std::uint32_t rare = interner.intern("Skyward Harp, \"Amos\" Bow");
+	for (long long i = 0; i < 100000; i++)
+	{
+		bool five = i % 10 == 9;
+		wishes.push_back(compactWish{ 1600000000 + i / 10 * 60, five ? rare : common, wishItemType::Weapon, static_cast<std::uint8_t>(five ? 5 : 3) });
+	}
+	db.insertWishes(Banner::Weapon, std::span<const compactWish>(wishes));
+
+	for (transferFormat format : { transferFormat::Csv, transferFormat::JsonLines })
+	{
+		std::string path = format == transferFormat::Csv ? "transferTest.csv" : "transferTest.jsonl";
+		transferStats stats;
+		ASSERT_TRUE(exportHistory(db, path, format, &stats));
+		EXPECT_GT(stats.bytes, 2 * g_transferChunkBytes);
+
+		InMemoryDatabase copy;
+		ASSERT_TRUE(importHistory(copy, path, format, false, &stats));
+		EXPECT_EQ(stats.rows, wishes.size());
+		EXPECT_EQ(stats.rejected, 0);
+		std::vector<compactWish> imported;
+		copy.getWishes(Banner::Weapon, imported);
+		ASSERT_EQ(imported.size(), wishes.size());
+		for (size_t i = 0; i < wishes.size(); i++)
+		{
+			ASSERT_EQ(imported[i].time, wishes[i].time);
+			ASSERT_EQ(imported[i].itemId, wishes[i].itemId);
+			ASSERT_EQ(imported[i].itemRarity, wishes[i].itemRarity);
+		}
+
+		// batches keep 10-pulls together, so import dedupe sees the same seq numbers
+		ASSERT_TRUE(importHistory(db, path, format, true, &stats));
+		EXPECT_EQ(stats.inserted, 0);
+	}
+}
+
+TEST_F(WishTransferSuite, LongRecordIsRejected)
+{
+	// unmatched quote would make the rest of the file one record, import has to skip it and go on with the next line
+	std::string content = "banner,time,itemType,itemName,rarity\nCharacter,2021-01-12 18:37:29,Weapon,\"Slingshot,3\n";
+	size_t rows = 0;
+	while (content.size() <= g_transferMaxRecordBytes + g_transferChunkBytes)
+	{
+		content += "Character," + std::to_string(1600000000 + rows) + ",Weapon,Slingshot,3\n";
+		rows++;
+	}
+	writeFile("transferTest.csv", content);
+
+	InMemoryDatabase db;
+	transferStats stats;
+	ASSERT_TRUE(importHistory(db, "transferTest.csv", transferFormat::Csv, false, &stats));
+	EXPECT_EQ(stats.rejected, 1);
+	EXPECT_EQ(stats.rows, rows);
+	EXPECT_EQ(db.count(Banner::Character), rows);
+}
+
+TEST_F(WishTransferSuite, FailedInsertFailsImport)
+{
+	std::string filename = "transferFailTest.db";
+	SQLDatabase db(filename);
+	writeFile("transferTest.csv", "banner,time,itemType,itemName,rarity\n"
+		"Weapon,2021-01-12 18:37:29,Weapon,Slingshot,3\n"
+		"Character,2021-01-12 18:37:29,Character,Ganyu,5\n");
+
+	sqlite3* cHandle;
+	ASSERT_EQ(sqlite3_open(filename.c_str(), &cHandle), SQLITE_OK);
+	ASSERT_EQ(sqlite3_exec(cHandle, "CREATE TRIGGER failWish BEFORE INSERT ON wishWeapon BEGIN SELECT RAISE(ABORT, 'forced'); END;",
+		nullptr, nullptr, nullptr), SQLITE_OK);
+	sqlite3_close(cHandle);
+
+	// inserted counts only the batches that were stored
+	transferStats stats;
+	EXPECT_FALSE(importHistory(db, "transferTest.csv", transferFormat::Csv, false, &stats));
+	EXPECT_EQ(stats.rows, 2);
+	EXPECT_EQ(stats.inserted, 1);
+	EXPECT_EQ(db.getStats(Banner::Weapon).total, 0);
+	EXPECT_EQ(db.getStats(Banner::Character).total, 1);
+}
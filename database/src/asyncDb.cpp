@@ -0,0 +1,225 @@
+#include "asyncDb.h"
+#include <algorithm>
+#include <stdexcept>
+
+// AsyncDatabase constructor
+// Takes ownership of the wrapped database, from now on only writer thread inserts into it
+AsyncDatabase::AsyncDatabase(std::unique_ptr<Database> db) : m_db(std::move(db))
+{
+	m_writerThread = std::thread(&AsyncDatabase::writerLoop, this);
+}
+
+// AsyncDatabase destructor
+// Writer thread drains everything that is still queued before it exits
+AsyncDatabase::~AsyncDatabase()
+{
+	{
+		std::lock_guard lock(m_queueMutex);
+		m_shutdown = true;
+	}
+	m_cv.notify_all();
+	if (m_writerThread.joinable())
+	{
+		m_writerThread.join();
+	}
+}
+
+// Waits for queued inserts, so the read sees everything inserted before the call
+void AsyncDatabase::getWishes(Banner banner, std::vector<wishEntry> &wishList)
+{
+	flush();
+	std::lock_guard lock(m_dbMutex);
+	m_db->getWishes(banner, wishList);
+}
+
+void AsyncDatabase::getWishes(Banner banner, std::vector<compactWish> &wishList)
+{
+	flush();
+	std::lock_guard lock(m_dbMutex);
+	m_db->getWishes(banner, wishList);
+}
+
+void AsyncDatabase::forEachWish(Banner banner, const std::function<void(const wishEntry&)> &visit)
+{
+	flush();
+	std::lock_guard lock(m_dbMutex);
+	m_db->forEachWish(banner, visit);
+}
+
+// Fire and forget versions, use insertWishAsync/insertWishesAsync if you need to know when wishes are stored
+void AsyncDatabase::insertWish(Banner banner, const wishEntry &wish)
+{
+	insertWishAsync(banner, wish);
+}
+
+// Queue has to own the wishes, so span is copied - pass an rvalue vector to avoid that
+void AsyncDatabase::insertWishes(Banner banner, std::span<const wishEntry> wishes)
+{
+	insertWishesAsync(banner, std::vector<wishEntry>(wishes.begin(), wishes.end()));
+}
+
+void AsyncDatabase::insertWishes(Banner banner, std::vector<wishEntry> &&wishes)
+{
+	insertWishesAsync(banner, std::move(wishes));
+}
+
+// Earlier inserts have to be stored first, otherwise import couldn't tell they are duplicates
+size_t AsyncDatabase::importWishes(Banner banner, std::span<const wishEntry> wishes)
+{
+	flush();
+	std::lock_guard lock(m_dbMutex);
+	return m_db->importWishes(banner, wishes);
+}
+
+wishMark AsyncDatabase::latestWish(Banner banner)
+{
+	flush();
+	std::lock_guard lock(m_dbMutex);
+	return m_db->latestWish(banner);
+}
+
+wishStats AsyncDatabase::getStats(Banner banner)
+{
+	flush();
+	std::lock_guard lock(m_dbMutex);
+	return m_db->getStats(banner);
+}
+
+// Example usecase:		auto done = db.insertWishAsync(Banner::Character, wish); ...ocr next screenshot...; done.wait();
+std::future<void> AsyncDatabase::insertWishAsync(Banner banner, wishEntry wish)
+{
+	std::vector<wishEntry> wishes;
+	wishes.push_back(std::move(wish));
+	return enqueue(banner, std::move(wishes));
+}
+
+std::future<void> AsyncDatabase::insertWishesAsync(Banner banner, std::vector<wishEntry> wishVec)
+{
+	return enqueue(banner, std::move(wishVec));
+}
+
+// Blocks until every request queued before the call is written
+void AsyncDatabase::flush()
+{
+	std::unique_lock lock(m_queueMutex);
+	unsigned long long target = m_enqueued;
+	m_drainedCv.wait(lock, [&] { return m_written >= target; });
+}
+
+std::future<void> AsyncDatabase::enqueue(Banner banner, std::vector<wishEntry> wishes)
+{
+	insertRequest request{ banner, std::move(wishes), std::promise<void>() };
+	std::future<void> future = request.done.get_future();
+
+	// Wait if we have too many requests on queue, writerThread will notify us
+	std::unique_lock lock(m_queueMutex);
+	m_drainedCv.wait(lock, [&] { return m_queue.size() < m_maxQueuedRequests; });
+	m_queue.emplace_back(std::move(request));
+	m_enqueued++;
+	lock.unlock();
+	m_cv.notify_one();
+
+	return future;
+}
+
+// Coalesces batch per banner, so each table gets a single transaction no matter how many requests were queued
+// Order of wishes within a banner is preserved
+// Backend would skip a wish with unparsable date, so a request with one fails as a whole before anything is written
+void AsyncDatabase::writeBatch(std::deque<insertRequest> &batch)
+{
+	std::array<std::vector<insertRequest*>, g_bannerCount> perBanner;
+	for (auto &request : batch)
+	{
+		auto invalid = std::find_if(request.wishes.begin(), request.wishes.end(),
+			[](const wishEntry &wish) { return dateToEpoch(wish.date) < 0; });
+		if (invalid != request.wishes.end())
+		{
+			request.done.set_exception(std::make_exception_ptr(std::invalid_argument("wish " + invalid->itemName + " has invalid date " + invalid->date)));
+			continue;
+		}
+		perBanner[static_cast<size_t>(request.banner)].push_back(&request);
+	}
+
+	std::lock_guard lock(m_dbMutex);
+	for (Banner banner : g_banners)
+	{
+		auto &requests = perBanner[static_cast<size_t>(banner)];
+		if (requests.empty())
+		{
+			continue;
+		}
+
+		std::vector<wishEntry> wishes;
+		if (requests.size() == 1)
+		{
+			wishes = std::move(requests.front()->wishes);
+		}
+		else
+		{
+			size_t count = 0;
+			for (auto request : requests)
+			{
+				count += request->wishes.size();
+			}
+			wishes.reserve(count);
+			for (auto request : requests)
+			{
+				std::move(request->wishes.begin(), request->wishes.end(), std::back_inserter(wishes));
+			}
+		}
+
+		std::exception_ptr error;
+		try
+		{
+			size_t inserted;
+			if (!m_db->tryInsertWishes(banner, std::move(wishes), inserted))
+			{
+				error = std::make_exception_ptr(std::runtime_error(std::string("wishes for ") + bannerTableName(banner) + " were not stored"));
+			}
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		for (auto request : requests)
+		{
+			if (error)
+			{
+				request->done.set_exception(error);
+			}
+			else
+			{
+				request->done.set_value();
+			}
+		}
+	}
+}
+
+// Loop for thread, that will take requests from m_queue and write them to wrapped database
+void AsyncDatabase::writerLoop()
+{
+	while (true)
+	{
+		// Everything that piles up while we are writing, is written together in the next round
+		std::unique_lock lock(m_queueMutex);
+		m_cv.wait(lock, [&] { return !m_queue.empty() || m_shutdown; });
+
+		if (m_queue.empty() && m_shutdown)
+		{
+			return;
+		}
+
+		std::deque<insertRequest> batch(std::make_move_iterator(m_queue.begin()),
+			std::make_move_iterator(m_queue.end()));
+		m_queue.clear();
+		lock.unlock();
+		m_drainedCv.notify_all();
+
+		writeBatch(batch);
+
+		lock.lock();
+		m_written += batch.size();
+		lock.unlock();
+		m_drainedCv.notify_all();
+	}
+}
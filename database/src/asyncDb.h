@@ -0,0 +1,80 @@
+#ifndef ASYNC_DATABASE_H
+#define ASYNC_DATABASE_H
+
+#include "db.h"
+#include <memory>
+#include <deque>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*
+Database decorator that moves inserts off the caller's thread.
+
+	insert requests are queued and a single writer thread drains them
+	everything queued since the last drain is coalesced per table into one insertWishes call (group commit)
+	every request gets a std::future, that becomes ready once its wishes are written,
+	if the backend couldn't store them (tryInsertWishes failed or threw) get() throws for every request of that table,
+	a request with unparsable date is not written at all and its get() throws std::invalid_argument
+	getWishes and flush wait for the queue to drain, so reads always see earlier inserts
+	importWishes runs on the caller's thread after the queue drains, its result (number of new wishes) is needed right away
+	destructor drains the queue before joining the writer, nothing queued is lost
+*/
+
+class AsyncDatabase : public Database
+{
+public:
+	AsyncDatabase(std::unique_ptr<Database> db);
+	~AsyncDatabase() override;
+
+	// disable copy and move
+	AsyncDatabase(const AsyncDatabase&) = delete;
+	void operator=(const AsyncDatabase&) = delete;
+	AsyncDatabase(AsyncDatabase&&) = delete;
+	void operator=(AsyncDatabase&&) = delete;
+
+	using Database::insertWishes;
+	void getWishes(Banner banner, std::vector<wishEntry> &wishList) override;
+	void getWishes(Banner banner, std::vector<compactWish> &wishList) override;
+	void insertWish(Banner banner, const wishEntry &wish) override;
+	void insertWishes(Banner banner, std::span<const wishEntry> wishes) override;
+	void insertWishes(Banner banner, std::vector<wishEntry> &&wishes) override;
+	size_t importWishes(Banner banner, std::span<const wishEntry> wishes) override;
+	wishMark latestWish(Banner banner) override;
+	wishStats getStats(Banner banner) override;
+	void forEachWish(Banner banner, const std::function<void(const wishEntry&)> &visit) override;
+
+	std::future<void> insertWishAsync(Banner banner, wishEntry wish);
+	std::future<void> insertWishesAsync(Banner banner, std::vector<wishEntry> wishVec);
+	void flush();
+
+private:
+	struct insertRequest
+	{
+		Banner banner;
+		std::vector<wishEntry> wishes;
+		std::promise<void> done;
+	};
+
+	std::future<void> enqueue(Banner banner, std::vector<wishEntry> wishes);
+	void writeBatch(std::deque<insertRequest> &batch);
+	void writerLoop();
+
+	std::unique_ptr<Database> m_db;
+	std::mutex m_dbMutex;
+
+	std::deque<insertRequest> m_queue;
+	std::mutex m_queueMutex;
+	std::condition_variable m_cv;
+	std::condition_variable m_drainedCv;
+	unsigned long long m_enqueued = 0;
+	unsigned long long m_written = 0;
+
+	const size_t m_maxQueuedRequests = 1000;
+
+	std::thread m_writerThread;
+	bool m_shutdown = false;
+};
+
+#endif /* ASYNC_DATABASE_H */
@@ -0,0 +1,183 @@
+#ifndef BANNER_SQL_H
+#define BANNER_SQL_H
+
+#include <array>
+#include <cstddef>
+
+/*
+Banners and the SQL text of their wish tables, built at compile time.
+
+	every banner has its own wish table, Banner is the only way to name one
+	sqlText is a null terminated char array whose length is part of the type, operator+ joins two of them,
+	so whole statements are assembled by the compiler and nothing is formatted when a query runs
+	bannerStatements<banner> has every statement for one banner, g_bannerSql lets runtime code pick them by Banner
+	wishTableColumns is the only definition of current wish table layout, CREATE TABLE of every banner uses it
+	(timeReceived, seq, itemId) is the natural key of a wish, seq is position of the wish among wishes with the same time (10-pull)
+	clusteredWishTableColumns is the optional layout (wishTableLayout::Clustered), WITHOUT ROWID table keyed by the natural key,
+	it has no id, so statements that read by id have a time ordered variant
+*/
+
+// One wish table per banner
+enum class Banner : unsigned char
+{
+	Character = 0,
+	Weapon = 1,
+	Standard = 2,
+	Beginner = 3
+};
+constexpr size_t g_bannerCount = 4;
+constexpr std::array<Banner, g_bannerCount> g_banners = { Banner::Character, Banner::Weapon, Banner::Standard, Banner::Beginner };
+
+// N includes terminating null, same as for string literal
+template <size_t N>
+struct sqlText
+{
+	char chars[N] = {};
+
+	constexpr sqlText() = default;
+	constexpr sqlText(const char(&str)[N])
+	{
+		for (size_t i = 0; i < N; i++)
+		{
+			chars[i] = str[i];
+		}
+	}
+
+	constexpr const char* c_str() const { return chars; }
+	constexpr size_t size() const { return N - 1; }
+};
+
+template <size_t N, size_t M>
+constexpr sqlText<N + M - 1> operator+(const sqlText<N> &left, const sqlText<M> &right)
+{
+	sqlText<N + M - 1> result;
+	for (size_t i = 0; i < N - 1; i++)
+	{
+		result.chars[i] = left.chars[i];
+	}
+	for (size_t i = 0; i < M; i++)
+	{
+		result.chars[N - 1 + i] = right.chars[i];
+	}
+	return result;
+}
+
+template <size_t N, size_t M>
+constexpr sqlText<N + M - 1> operator+(const sqlText<N> &left, const char(&right)[M])
+{
+	return left + sqlText<M>(right);
+}
+
+template <size_t N, size_t M>
+constexpr sqlText<N + M - 1> operator+(const char(&left)[N], const sqlText<M> &right)
+{
+	return sqlText<N>(left) + right;
+}
+
+// Every banner has its own specialization, a new Banner without one doesn't compile instead of reusing some table
+template <Banner banner>
+constexpr auto bannerTable = []
+{
+	static_assert(banner != banner, "bannerTable has no specialization for this banner");
+	return sqlText("");
+}();
+template <>
+constexpr auto bannerTable<Banner::Beginner> = sqlText("wishBeginner");
+template <>
+constexpr auto bannerTable<Banner::Character> = sqlText("wishCharacter");
+template <>
+constexpr auto bannerTable<Banner::Weapon> = sqlText("wishWeapon");
+template <>
+constexpr auto bannerTable<Banner::Standard> = sqlText("wishStandard");
+
+// Column list of every wish table, timeReceived is epoch seconds
+constexpr auto wishTableColumns = sqlText(" (id integer PRIMARY KEY AUTOINCREMENT, itemId integer NOT NULL REFERENCES items(id),"
+	" timeReceived integer NOT NULL, itemRarity integer NOT NULL, seq integer NOT NULL DEFAULT 0);");
+
+// Clustered layout, rows are stored in b-tree of the natural key, so time order is the storage order
+constexpr auto clusteredWishTableColumns = sqlText(" (itemId integer NOT NULL REFERENCES items(id), timeReceived integer NOT NULL,"
+	" itemRarity integer NOT NULL, seq integer NOT NULL DEFAULT 0, PRIMARY KEY (timeReceived, seq, itemId)) WITHOUT ROWID;");
+
+template <Banner banner>
+struct bannerStatements
+{
+	static constexpr auto table = bannerTable<banner>;
+	static constexpr auto createTable = "CREATE TABLE IF NOT EXISTS " + table + wishTableColumns;
+	static constexpr auto createKeyIndex = "CREATE UNIQUE INDEX IF NOT EXISTS " + table + "_key ON " + table + "(timeReceived, seq, itemId);";
+	static constexpr auto selectWishes = "SELECT items.itemType, items.itemName, w.timeReceived, w.itemRarity FROM " + table +
+		" AS w JOIN items ON items.id = w.itemId ORDER BY w.id;";
+	static constexpr auto selectCompactWishes = "SELECT itemId, timeReceived, itemRarity FROM " + table + " ORDER BY id;";
+	static constexpr auto insertWish = "INSERT INTO " + table + "(itemId, timeReceived, itemRarity, seq) VALUES(?, ?, ?, ?);";
+	static constexpr auto importWish = "INSERT INTO " + table + "(itemId, timeReceived, itemRarity, seq) VALUES(?, ?, ?, ?)"
+		" ON CONFLICT DO NOTHING;";
+	static constexpr auto selectNextSeq = "SELECT COALESCE(max(seq) + 1, 0) FROM " + table + " WHERE timeReceived = ?;";
+	static constexpr auto selectKeys = "SELECT timeReceived, seq, itemId FROM " + table + ";";
+	// Whole wishStats in one pass inside sqlite, last row of the window is the current state (pity is in sqlFunctions.h)
+	static constexpr auto selectStats = sqlText("SELECT count(*) OVER w, sum(itemRarity = 3) OVER w, sum(itemRarity = 4) OVER w,"
+		" sum(itemRarity = 5) OVER w, pity(itemRarity, 4) OVER w, pity(itemRarity, 5) OVER w,"
+		" COALESCE(max(CASE WHEN itemRarity >= 5 THEN timeReceived END) OVER w, -1) FROM ") + table +
+		" WINDOW w AS (ORDER BY timeReceived, seq ROWS UNBOUNDED PRECEDING) ORDER BY timeReceived DESC, seq DESC LIMIT 1;";
+	static constexpr auto selectWishRange = "SELECT itemId, timeReceived, itemRarity FROM " + table + " WHERE id BETWEEN ? AND ? ORDER BY id;";
+	// Upper bound of row count from the ends of rowid, two lookups instead of count(*) scanning the table
+	static constexpr auto selectRowBound = "SELECT COALESCE((SELECT max(id) FROM " + table + ") - (SELECT min(id) FROM " + table + ") + 1, 0);";
+	static constexpr auto selectLatest = "SELECT timeReceived, seq FROM " + table + " ORDER BY timeReceived DESC, seq DESC LIMIT 1;";
+	// Clustered layout
+	static constexpr auto createClusteredTable = "CREATE TABLE IF NOT EXISTS " + table + clusteredWishTableColumns;
+	static constexpr auto selectWishesInTimeOrder = "SELECT items.itemType, items.itemName, w.timeReceived, w.itemRarity FROM " + table +
+		" AS w JOIN items ON items.id = w.itemId ORDER BY w.timeReceived, w.seq;";
+	static constexpr auto selectCompactWishesInTimeOrder = "SELECT itemId, timeReceived, itemRarity FROM " + table + " ORDER BY timeReceived, seq;";
+	static constexpr auto countWishes = "SELECT count(*) FROM " + table + ";";
+};
+
+// Pointers into bannerStatements, index is Banner
+struct bannerSql
+{
+	const char* table;
+	const char* createTable;
+	const char* createKeyIndex;
+	const char* selectWishes;
+	const char* selectCompactWishes;
+	const char* insertWish;
+	const char* importWish;
+	const char* selectNextSeq;
+	const char* selectKeys;
+	const char* selectStats;
+	const char* selectLatest;
+	const char* selectWishRange;
+	const char* selectRowBound;
+	const char* createClusteredTable;
+	const char* selectWishesInTimeOrder;
+	const char* selectCompactWishesInTimeOrder;
+	const char* countWishes;
+};
+
+template <Banner banner>
+constexpr bannerSql makeBannerSql()
+{
+	using statements = bannerStatements<banner>;
+	return bannerSql{ statements::table.c_str(), statements::createTable.c_str(), statements::createKeyIndex.c_str(),
+		statements::selectWishes.c_str(), statements::selectCompactWishes.c_str(), statements::insertWish.c_str(),
+		statements::importWish.c_str(), statements::selectNextSeq.c_str(), statements::selectKeys.c_str(),
+		statements::selectStats.c_str(), statements::selectLatest.c_str(), statements::selectWishRange.c_str(),
+		statements::selectRowBound.c_str(), statements::createClusteredTable.c_str(), statements::selectWishesInTimeOrder.c_str(),
+		statements::selectCompactWishesInTimeOrder.c_str(), statements::countWishes.c_str() };
+}
+
+constexpr std::array<bannerSql, g_bannerCount> g_bannerSql = {
+	makeBannerSql<Banner::Character>(),
+	makeBannerSql<Banner::Weapon>(),
+	makeBannerSql<Banner::Standard>(),
+	makeBannerSql<Banner::Beginner>() };
+
+// Example usecase:		sqlite3_prepare_v2(handle, sqlFor(banner).insertWish, -1, &stmt, NULL);
+constexpr const bannerSql& sqlFor(Banner banner)
+{
+	return g_bannerSql[static_cast<size_t>(banner)];
+}
+
+constexpr const char* bannerTableName(Banner banner)
+{
+	return sqlFor(banner).table;
+}
+
+#endif /* BANNER_SQL_H */
@@ -0,0 +1,137 @@
+#include "changeFeed.h"
+#include <algorithm>
+#include <cstring>
+
+void ChangeFeed::attach(sqlite3* handle)
+{
+	sqlite3_update_hook(handle, &ChangeFeed::onUpdate, this);
+	sqlite3_commit_hook(handle, &ChangeFeed::onCommit, this);
+	sqlite3_rollback_hook(handle, &ChangeFeed::onRollback, this);
+}
+
+void ChangeFeed::detach(sqlite3* handle)
+{
+	sqlite3_update_hook(handle, nullptr, nullptr);
+	sqlite3_commit_hook(handle, nullptr, nullptr);
+	sqlite3_rollback_hook(handle, nullptr, nullptr);
+}
+
+ChangeFeed::subscription ChangeFeed::subscribe(wishBatchCallback callback)
+{
+	std::lock_guard lock(m_mutex);
+	m_subscribers.emplace_back(m_nextId, std::move(callback));
+	return m_nextId++;
+}
+
+void ChangeFeed::unsubscribe(subscription id)
+{
+	std::lock_guard lock(m_mutex);
+	std::erase_if(m_subscribers, [&](auto &subscriber) { return subscriber.first == id; });
+}
+
+bool ChangeFeed::hasSubscribers() const
+{
+	std::lock_guard lock(m_mutex);
+	return !m_subscribers.empty();
+}
+
+std::array<ChangeFeed::rowRange, g_bannerCount> ChangeFeed::takeCommitted()
+{
+	return std::exchange(m_committed, {});
+}
+
+// Subscribers are copied, so callback can unsubscribe itself without invalidating the loop
+void ChangeFeed::publish(const wishBatch &batch) const
+{
+	std::vector<std::pair<subscription, wishBatchCallback>> subscribers;
+	{
+		std::lock_guard lock(m_mutex);
+		subscribers = m_subscribers;
+	}
+	for (auto &subscriber : subscribers)
+	{
+		subscriber.second(batch);
+	}
+}
+
+// Called for every row, so only inserts into wish tables of the main db are looked at
+void ChangeFeed::onUpdate(void* feed, int operation, const char* database, const char* table, sqlite3_int64 rowid)
+{
+	if (operation != SQLITE_INSERT || std::strcmp(database, "main") != 0)
+	{
+		return;
+	}
+	for (Banner banner : g_banners)
+	{
+		if (std::strcmp(table, bannerTableName(banner)) == 0)
+		{
+			rowRange &range = static_cast<ChangeFeed*>(feed)->m_pending[static_cast<size_t>(banner)];
+			if (range.empty())
+			{
+				range.first = range.last = rowid;
+			}
+			else
+			{
+				range.first = std::min<long long>(range.first, rowid);
+				range.last = std::max<long long>(range.last, rowid);
+			}
+			return;
+		}
+	}
+}
+
+// Returning 0 lets the commit go on
+int ChangeFeed::onCommit(void* feed)
+{
+	ChangeFeed* self = static_cast<ChangeFeed*>(feed);
+	for (size_t i = 0; i < g_bannerCount; i++)
+	{
+		rowRange &pending = self->m_pending[i];
+		if (pending.empty())
+		{
+			continue;
+		}
+		rowRange &committed = self->m_committed[i];
+		committed.first = committed.empty() ? pending.first : std::min(committed.first, pending.first);
+		committed.last = std::max(committed.last, pending.last);
+		pending = rowRange{};
+	}
+	return 0;
+}
+
+void ChangeFeed::onRollback(void* feed)
+{
+	static_cast<ChangeFeed*>(feed)->m_pending = {};
+}
+
+wishBatchCallback WishBatchQueue::callback()
+{
+	return [this](const wishBatch &batch) { push(batch); };
+}
+
+void WishBatchQueue::push(const wishBatch &batch)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_batches.push_back(batch);
+	}
+	m_cv.notify_one();
+}
+
+bool WishBatchQueue::pop(wishBatch &batch, std::chrono::milliseconds timeout)
+{
+	std::unique_lock lock(m_mutex);
+	if (!m_cv.wait_for(lock, timeout, [&] { return !m_batches.empty(); }))
+	{
+		return false;
+	}
+	batch = std::move(m_batches.front());
+	m_batches.pop_front();
+	return true;
+}
+
+size_t WishBatchQueue::size() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_batches.size();
+}
@@ -0,0 +1,95 @@
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include "db.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*
+Committed inserts of wish tables, published to subscribers so they never have to poll getWishes.
+
+	sqlite3_update_hook reports every row written by the connection, inserts into wish tables are kept as rowid range per banner
+	(one writer, so rows inserted by one transaction get consecutive ids)
+	commit hook moves the ranges to committed, rollback hook drops them, so rolled back rows are never published
+	hooks run inside sqlite and must not use the connection, rows are read and published by SQLDatabase right after COMMIT
+	update hook doesn't fire for WITHOUT ROWID tables, SQLDatabase publishes wishes of clustered tables as it inserted them
+	subscribers are called on the thread that committed, after the transaction, so they may read the db,
+	WishBatchQueue hands batches over to another thread (viewer)
+*/
+
+// Wishes committed into one banner since the last publish (one transaction of writeWishes), in insertion order
+struct wishBatch
+{
+	Banner banner;
+	// rowids of first and last wish, -1 for clustered table (no rowid)
+	long long firstRow;
+	long long lastRow;
+	std::vector<compactWish> wishes;
+};
+using wishBatchCallback = std::function<void(const wishBatch&)>;
+
+class ChangeFeed
+{
+public:
+	// rows last < first is empty range
+	struct rowRange
+	{
+		long long first = 0;
+		long long last = -1;
+
+		bool empty() const { return last < first; }
+	};
+	using subscription = size_t;
+
+	// Installs hooks on handle, they replace hooks set before (one feed per connection)
+	void attach(sqlite3* handle);
+	void detach(sqlite3* handle);
+
+	// Example usecase:		auto id = feed.subscribe([&](const wishBatch &batch) { stats.add(batch); }); ... feed.unsubscribe(id);
+	subscription subscribe(wishBatchCallback callback);
+	void unsubscribe(subscription id);
+	bool hasSubscribers() const;
+
+	// Ranges committed since the last call, empty ranges for banners without new rows
+	std::array<rowRange, g_bannerCount> takeCommitted();
+	// Calls every subscriber, callbacks may subscribe/unsubscribe
+	void publish(const wishBatch &batch) const;
+
+private:
+	static void onUpdate(void* feed, int operation, const char* database, const char* table, sqlite3_int64 rowid);
+	static int onCommit(void* feed);
+	static void onRollback(void* feed);
+
+	// pending belongs to the open transaction, hooks run on the thread that uses the connection
+	std::array<rowRange, g_bannerCount> m_pending;
+	std::array<rowRange, g_bannerCount> m_committed;
+
+	std::vector<std::pair<subscription, wishBatchCallback>> m_subscribers;
+	subscription m_nextId = 1;
+	mutable std::mutex m_mutex;
+};
+
+// Subscriber that queues batches for another thread
+// Example usecase:		db.subscribe(queue.callback()); ... while (queue.pop(batch, std::chrono::milliseconds(100))) { view.add(batch); }
+class WishBatchQueue
+{
+public:
+	wishBatchCallback callback();
+	void push(const wishBatch &batch);
+	// Waits up to timeout for a batch, returns false if none came
+	bool pop(wishBatch &batch, std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+	size_t size() const;
+
+private:
+	std::deque<wishBatch> m_batches;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cv;
+};
+
+#endif /* CHANGE_FEED_H */
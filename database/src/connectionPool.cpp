@@ -0,0 +1,147 @@
+#include "connectionPool.h"
+#include <algorithm>
+#include <iostream>
+
+// SQLConnectionPool constructor
+// Database file has to exist already (read-only connections can't create it), size is clamped to at least 1
+SQLConnectionPool::SQLConnectionPool(std::string dbF, size_t size) : m_dbFilename(dbF), m_size(size ? size : 1)
+{
+	m_connections.reserve(m_size);
+	m_idle.reserve(m_size);
+}
+
+// SQLConnectionPool destructor
+// All connections have to be checked in by now
+SQLConnectionPool::~SQLConnectionPool()
+{
+	for (auto handle : m_connections)
+	{
+		sqlite3_close(handle);
+	}
+}
+
+// Takes idle connection, opens a new one if we are below size, otherwise waits for checkin
+// Returns nullptr if connection couldn't be opened
+sqlite3* SQLConnectionPool::checkout()
+{
+	std::unique_lock lock(m_mutex);
+	m_cv.wait(lock, [&] { return !m_idle.empty() || m_connections.size() < m_size; });
+
+	if (!m_idle.empty())
+	{
+		sqlite3* handle = m_idle.back();
+		m_idle.pop_back();
+		applySchedule(handle);
+		return handle;
+	}
+
+	sqlite3* handle = open();
+	if (handle)
+	{
+		m_connections.push_back(handle);
+		applySchedule(handle);
+	}
+	return handle;
+}
+
+void SQLConnectionPool::checkin(sqlite3* handle)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_idle.push_back(handle);
+	}
+	m_cv.notify_one();
+}
+
+// Example usecase:		auto conn = pool.connection(); if (conn) { sqlite3_prepare_v2(conn.get(), ...); }
+SQLConnectionPool::pooledConnection SQLConnectionPool::connection()
+{
+	return pooledConnection(*this, checkout());
+}
+
+// Same as SQLDatabase::getWishes, but can be called from many threads at once
+void SQLConnectionPool::getWishes(Banner banner, std::vector<wishEntry> &wishList)
+{
+	auto conn = connection();
+	if (!conn)
+	{
+		return;
+	}
+	SQLDatabase::selectWishes(conn.get(), banner, wishList);
+}
+
+// Pool smaller than g_bannerCount still works, threads wait for connections in checkout
+void SQLConnectionPool::loadAll(std::array<std::vector<wishEntry>, g_bannerCount> &wishLists)
+{
+	auto load = [&](Banner banner) {
+		auto conn = connection();
+		if (!conn)
+		{
+			return;
+		}
+		std::vector<wishEntry> &wishList = wishLists[static_cast<size_t>(banner)];
+		wishList.reserve(rowBound(conn.get(), banner));
+		SQLDatabase::selectWishes(conn.get(), banner, wishList);
+	};
+
+	// first banner is read on this thread
+	std::vector<std::thread> threads;
+	threads.reserve(g_bannerCount - 1);
+	for (size_t i = 1; i < g_bannerCount; i++)
+	{
+		threads.emplace_back(load, g_banners[i]);
+	}
+	load(g_banners[0]);
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+// Returns 0 if table can't be read, selectWishes reports the error then
+// Clustered table has no rowid, its count(*) walks the table (sequential pages) instead
+size_t SQLConnectionPool::rowBound(sqlite3* handle, Banner banner)
+{
+	const bannerSql &sql = sqlFor(banner);
+	sqlite3_stmt* stmt;
+	const char* text = SQLDatabase::tableLayout(handle, banner) == wishTableLayout::Clustered ? sql.countWishes : sql.selectRowBound;
+	if (sqlite3_prepare_v2(handle, text, -1, &stmt, NULL) != SQLITE_OK)
+	{
+		return 0;
+	}
+	long long bound = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
+	sqlite3_finalize(stmt);
+	return static_cast<size_t>(std::max(bound, 0LL));
+}
+
+void SQLConnectionPool::setBannerSchedule(std::vector<bannerPeriod> periods)
+{
+	std::lock_guard lock(m_mutex);
+	m_schedule = std::move(periods);
+	m_scheduleVersion++;
+}
+
+// Called with m_mutex held, handle isn't used by anyone else at that point
+void SQLConnectionPool::applySchedule(sqlite3* handle)
+{
+	unsigned int &version = m_connectionSchedule[handle];
+	if (version != m_scheduleVersion && ::setBannerSchedule(handle, m_schedule))
+	{
+		version = m_scheduleVersion;
+	}
+}
+
+sqlite3* SQLConnectionPool::open()
+{
+	sqlite3* handle = nullptr;
+	int ret = sqlite3_open_v2(m_dbFilename.c_str(), &handle, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+	if (ret != SQLITE_OK)
+	{
+		// error occured
+		std::cout << "error: " << sqlite3_errmsg(handle) << std::endl;
+		sqlite3_close(handle);
+		return nullptr;
+	}
+	registerWishFunctions(handle);
+	return handle;
+}
@@ -0,0 +1,83 @@
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include "db.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+
+/*
+Pool of read-only sqlite connections to a database created by SQLDatabase.
+
+	SQLDatabase switches the file to WAL, so readers don't block each other or the writer
+	connections are opened lazily, up to the configured size
+	each connection is used by one thread at a time, so they are opened with SQLITE_OPEN_NOMUTEX
+	checkout blocks when all connections are in use
+	every connection has the wish functions of sqlFunctions.h, new banner schedule reaches a connection at its next checkout,
+	connection that is checked out keeps using the one it had
+	loadAll reads every banner at once, each on its own thread and connection, so it takes as long as the largest banner
+*/
+
+class SQLConnectionPool
+{
+public:
+	// Returns connection to the pool when it goes out of scope
+	class pooledConnection
+	{
+	public:
+		pooledConnection(SQLConnectionPool &pool, sqlite3* handle) : m_pool(pool), m_handle(handle) {}
+		~pooledConnection() { if (m_handle) m_pool.checkin(m_handle); }
+		pooledConnection(const pooledConnection&) = delete;
+		void operator=(const pooledConnection&) = delete;
+
+		sqlite3* get() const { return m_handle; }
+		explicit operator bool() const { return m_handle != nullptr; }
+
+	private:
+		SQLConnectionPool &m_pool;
+		sqlite3* m_handle;
+	};
+
+	SQLConnectionPool(std::string dbF = g_filename, size_t size = std::thread::hardware_concurrency());
+	~SQLConnectionPool();
+
+	// disable copy and move
+	SQLConnectionPool(const SQLConnectionPool&) = delete;
+	void operator=(const SQLConnectionPool&) = delete;
+	SQLConnectionPool(SQLConnectionPool&&) = delete;
+	void operator=(SQLConnectionPool&&) = delete;
+
+	sqlite3* checkout();
+	void checkin(sqlite3* handle);
+	pooledConnection connection();
+
+	void getWishes(Banner banner, std::vector<wishEntry> &wishList);
+	// Index is Banner, lists are reserved from rowid range (count of clustered table) before rows are read
+	// Example usecase:		std::array<std::vector<wishEntry>, g_bannerCount> all; pool.loadAll(all);
+	void loadAll(std::array<std::vector<wishEntry>, g_bannerCount> &wishLists);
+	// Example usecase:		pool.setBannerSchedule(periods); auto conn = pool.connection(); ... "SELECT banner_of(timeReceived, 0) ..."
+	void setBannerSchedule(std::vector<bannerPeriod> periods);
+	size_t size() const { return m_size; }
+
+private:
+	sqlite3* open();
+	static size_t rowBound(sqlite3* handle, Banner banner);
+	void applySchedule(sqlite3* handle);
+
+	const std::string m_dbFilename;
+	const size_t m_size;
+
+	std::vector<sqlite3*> m_connections;
+	std::vector<sqlite3*> m_idle;
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	// Version of m_schedule each connection has registered, version 0 is the empty schedule of registerWishFunctions
+	std::vector<bannerPeriod> m_schedule;
+	unsigned int m_scheduleVersion = 0;
+	std::unordered_map<sqlite3*, unsigned int> m_connectionSchedule;
+};
+
+#endif /* CONNECTION_POOL_H */
@@ -1,18 +1,33 @@
 #include "db.h"
+#include "changeFeed.h"
 #include <iostream>
+#include <chrono>
+#include <algorithm>
 
 // https://videlais.com/2018/12/13/c-with-sqlite3-part-3-inserting-and-selecting-data/
 
 
-SQLDatabase::SQLDatabase(std::string dbF)
+SQLDatabase::SQLDatabase(std::string dbF, migrationProgressCallback progress)
 {
 	dbFilename = dbF;
+	progressCallback = progress;
 	init();
 	setupDB();
+	loadLayouts();
+	changeFeed = std::make_unique<ChangeFeed>();
+	changeFeed->attach(connectionHandle);
 }
 
 SQLDatabase::~SQLDatabase()
 {
+	// sqlite won't close connection with unfinalized statements
+	finalizeStatements();
+	changeFeed->detach(connectionHandle);
+	if (statementProfiler)
+	{
+		statementProfiler->detach(connectionHandle);
+		statementProfiler->summary();
+	}
 	int ret = sqlite3_close(connectionHandle);
 }
 
@@ -34,16 +49,59 @@ int infoTableCallback(void* notUsed, int argc, char** argv, char** colName)
 	return 0;
 }
 
-void SQLDatabase::getWishes(std::string tableName, std::vector<wishEntry> &wishList)
+void SQLDatabase::getWishes(Banner banner, std::vector<wishEntry> &wishList)
 {
-	sqlite3_stmt* stmt;
+	selectWishes(connectionHandle, banner, wishList, bannerStatement(banner, SelectWishes));
+}
 
-	char command[64];
-	sprintf(command, "SELECT * FROM %s;", tableName.c_str());
-	int rc = sqlite3_prepare_v2(connectionHandle, command, -1, &stmt, NULL);
+// Rows are streamed straight from sqlite, only one wishEntry exists at a time
+void SQLDatabase::forEachWish(Banner banner, const std::function<void(const wishEntry&)> &visit)
+{
+	selectWishes(connectionHandle, banner, visit, bannerStatement(banner, SelectWishes));
+}
 
-	if (rc != SQLITE_OK) {
-		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+// Reads whole wish table using given connection, elements already in wishList are overwritten in place
+// Static, so read-only connections (see SQLConnectionPool) can share the same code
+void SQLDatabase::selectWishes(sqlite3* handle, Banner banner, std::vector<wishEntry> &wishList, sqlite3_stmt* stmt)
+{
+	size_t count = 0;
+	selectWishRows(handle, banner, [&](wishItemType type, std::string_view itemName, long long time, unsigned int rarity) {
+		if (count < wishList.size())
+		{
+			assignWish(wishList[count], type, itemName, time, rarity);
+		}
+		else
+		{
+			wishList.emplace_back(itemTypeToString(type), std::string(itemName), epochToDate(time), rarity);
+		}
+		count++;
+	}, stmt);
+	wishList.erase(wishList.begin() + count, wishList.end());
+}
+
+void SQLDatabase::selectWishes(sqlite3* handle, Banner banner, const std::function<void(const wishEntry&)> &visit, sqlite3_stmt* stmt)
+{
+	wishEntry wish("", "", "", 0);
+	selectWishRows(handle, banner, [&](wishItemType type, std::string_view itemName, long long time, unsigned int rarity) {
+		assignWish(wish, type, itemName, time, rarity);
+		visit(wish);
+	}, stmt);
+}
+
+// Without stmt the select is prepared just for this call, cached stmt is only reset so it can be stepped again
+void SQLDatabase::selectWishRows(sqlite3* handle, Banner banner, const wishRowVisitor &visit, sqlite3_stmt* stmt)
+{
+	bool ownStatement = !stmt;
+	int rc = SQLITE_OK;
+	if (ownStatement)
+	{
+		const bannerSql &sql = sqlFor(banner);
+		rc = sqlite3_prepare_v2(handle, tableLayout(handle, banner) == wishTableLayout::Clustered ? sql.selectWishesInTimeOrder : sql.selectWishes,
+			-1, &stmt, NULL);
+	}
+
+	if (rc != SQLITE_OK || !stmt) {
+		std::cout << "error: " << sqlite3_errmsg(handle);
 		return;
 	}
 
@@ -53,252 +111,1501 @@ void SQLDatabase::getWishes(std::string tableName, std::vector<wishEntry> &wishL
 		// People typically use an (unsigned char *) type to indicate that the data is binary and not plain ASCII text.
 		// Meaning you might need some encoding/decoding here, if data is UTF-8 symbol? With ICU library?
 		// Example of expected row:
-		// 1|Character|Diluc|2020-11-07 14:53:16|5
-		const char* type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-		const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-		const char* date = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-		int rarity = sqlite3_column_int(stmt, 4);
+		// 1|Diluc|1604760796|5
+		wishItemType type = static_cast<wishItemType>(sqlite3_column_int(stmt, 0));
+		const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+		long long date = sqlite3_column_int64(stmt, 2);
+		int rarity = sqlite3_column_int(stmt, 3);
 
-		if (!type || !name || !date)
+		if (!name)
 		{
-			// One of the pointers is null, db is corrupted
+			// Pointer is null, db is corrupted
 			exit(1);
 		}
 
-		wishList.push_back(wishEntry(type, name, date, rarity));
+		visit(type, std::string_view(name, sqlite3_column_bytes(stmt, 1)), date, rarity);
 	}
 
 	if (rc != SQLITE_DONE) {
-		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		std::cout << "error: " << sqlite3_errmsg(handle);
+	}
+	if (ownStatement)
+	{
+		sqlite3_finalize(stmt);
+	}
+	else
+	{
+		sqlite3_reset(stmt);
 	}
-	sqlite3_finalize(stmt);
 }
 
-void SQLDatabase::insertWish(std::string tableName, wishEntry wish)
+// Assigning into existing strings reuses their buffers
+void SQLDatabase::assignWish(wishEntry &wish, wishItemType type, std::string_view itemName, long long time, unsigned int rarity)
 {
-	char* errMsg = 0;
-	char command[256];
-	sprintf(command, "INSERT INTO %s(itemType, itemName, timeReceived, itemRarity) VALUES(\"%s\",\"%s\",\"%s\",\"%u\");",
-		tableName.c_str(), wish.itemType.c_str(), wish.itemName.c_str(), wish.date.c_str(), wish.itemRarity);
-	int rc = sqlite3_exec(connectionHandle, command, callback, 0, &errMsg);
-	if (rc != SQLITE_OK)
+	wish.itemType.assign(itemTypeToString(type));
+	wish.itemName.assign(itemName);
+	epochToDate(time, wish.date);
+	wish.itemRarity = rarity;
+}
+
+void SQLDatabase::insertWishes(Banner banner, std::span<const wishEntry> wishes)
+{
+	size_t inserted;
+	if (writeWishes(banner, wishes, false, inserted))
 	{
-		// error occured
-		std::cout << "Error: " << errMsg << std::endl;
+		std::cout << "inserted " << inserted << (inserted == 1 ? " Wish\n" : " Wishes\n");
 	}
+}
+
+bool SQLDatabase::tryInsertWishes(Banner banner, std::vector<wishEntry> &&wishes, size_t &inserted)
+{
+	return writeWishes(banner, std::span<const wishEntry>(wishes), false, inserted);
+}
 
-	std::cout << "inserted Wish\n";
+size_t SQLDatabase::importWishes(Banner banner, std::span<const wishEntry> wishes)
+{
+	size_t inserted;
+	writeWishes(banner, wishes, true, inserted);
+	std::cout << "imported " << inserted << " new Wishes\n";
+	return inserted;
 }
 
-void SQLDatabase::insertWishes(std::string tableName, std::vector<wishEntry> wishVec)
+// Reads ids straight from wish table, items are resolved from itemsById cache instead of a join
+// Nothing is allocated per row, capacity of wishList is reused
+void SQLDatabase::getWishes(Banner banner, std::vector<compactWish> &wishList)
 {
-	char* errMsg = 0;
-	std::vector<std::string> commands = { "BEGIN;" };
-	
-	for (auto &wish : wishVec)
+	wishList.clear();
+
+	sqlite3_stmt* stmt = bannerStatement(banner, SelectCompactWishes);
+	if (!stmt)
 	{
-		char command[256];
-		sprintf(command, "INSERT INTO %s(itemType, itemName, timeReceived, itemRarity) VALUES(\"%s\",\"%s\",\"%s\",\"%u\");",
-			tableName.c_str(), wish.itemType.c_str(), wish.itemName.c_str(), wish.date.c_str(), wish.itemRarity);
-		commands.push_back(command);
+		return;
 	}
-	commands.push_back("COMMIT;");
+	readCompactWishes(stmt, wishList);
+}
 
-	for (auto &stmt : commands)
+void SQLDatabase::readCompactWishes(sqlite3_stmt* stmt, std::vector<compactWish> &wishList)
+{
+	int rc;
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
 	{
-		int rc = sqlite3_exec(connectionHandle, stmt.c_str(), callback, 0, &errMsg);
-		if (rc != SQLITE_OK)
+		int itemId = sqlite3_column_int(stmt, 0);
+		if (itemId < 0 || static_cast<size_t>(itemId) >= itemsById.size() || itemsById[itemId].nameId == StringInterner::npos)
 		{
-			// error occured
-			std::cout << "Error: " << errMsg << std::endl;
+			// item added by someone else (or cache is empty), reload once
+			if (!loadItems() || itemId < 0 || static_cast<size_t>(itemId) >= itemsById.size() || itemsById[itemId].nameId == StringInterner::npos)
+			{
+				// Wish points to item that doesn't exist, db is corrupted
+				exit(1);
+			}
 		}
+
+		const itemInfo &item = itemsById[itemId];
+		wishList.push_back(compactWish{ sqlite3_column_int64(stmt, 1), item.nameId, item.type,
+			static_cast<std::uint8_t>(sqlite3_column_int(stmt, 2)) });
+	}
+
+	if (rc != SQLITE_DONE) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
 	}
-	std::cout << "inserted multiple Wishes\n";
+	sqlite3_reset(stmt);
 }
 
-void SQLDatabase::init()
+void SQLDatabase::insertWishes(Banner banner, std::span<const compactWish> wishes)
 {
-	int ret = sqlite3_open(dbFilename.c_str(), &connectionHandle);
-	if (ret != SQLITE_OK)
-	{
-		// error occured
-		return;
-	}
+	size_t inserted;
+	writeWishes(banner, wishes, false, inserted);
 }
 
-void SQLDatabase::setupDB()
+bool SQLDatabase::tryInsertWishes(Banner banner, std::span<const compactWish> wishes, size_t &inserted)
+{
+	return writeWishes(banner, wishes, false, inserted);
+}
+
+static const compactWish& asCompactWish(const compactWish &wish)
+{
+	return wish;
+}
+
+static compactWish asCompactWish(const wishEntry &wish)
+{
+	return toCompactWish(wish);
+}
+
+// Inserts wishes in a single transaction, together with any items that are new to items table
+// Works for both wishEntry and compactWish, each wish is converted on the fly so nothing is copied
+// Wishes with unparsable date are skipped, item that can't be stored rolls the whole batch back
+// Appended wishes continue seq after wishes already stored with the same time,
+// idempotent (import) numbers them from 0 and lets the unique key skip those that are stored
+// inserted is the number of wishes that were new, returns false if the transaction was rolled back
+template <typename T>
+bool SQLDatabase::writeWishes(Banner banner, std::span<const T> wishes, bool idempotent, size_t &inserted)
 {
-	// First search db for systemInfo table
-	std::unordered_set<std::string> tables;
-	getTables(tables);
+	inserted = 0;
+	// IMMEDIATE takes the write lock before caches are checked, so nobody can commit between the check and our COMMIT
+	if (!executeCommand("BEGIN IMMEDIATE;"))
+	{
+		return false;
+	}
+	dropStaleCaches();
 
-	if (tables.contains("systemInfo"))
+	size_t bannerIndex = static_cast<size_t>(banner);
+	sqlite3_stmt* stmt = bannerStatement(banner, idempotent ? ImportWish : InsertWish);
+	sqlite3_stmt* nextSeqStmt = bannerStatement(banner, SelectNextSeq);
+	// items, keys and marks added in this transaction are gone after rollback
+	auto rollback = [&]()
 	{
-		// We got systemInfo table, let's check it's latest version
-		int version = infoTableGetLatestVersion();
-		if (version == 0)
+		executeCommand("ROLLBACK;");
+		clearItemCache();
+		clearBannerCaches();
+		inserted = 0;
+		return false;
+	};
+	if (!stmt || !nextSeqStmt || (idempotent && !loadStoredKeys(banner)) || !loadStats(banner))
+	{
+		return rollback();
+	}
+	latestWish(banner);
+
+	// update hook doesn't see WITHOUT ROWID tables, so change feed gets wishes of clustered table from here
+	bool collect = layouts[bannerIndex] == wishTableLayout::Clustered && changeFeed->hasSubscribers();
+	std::vector<compactWish> collected;
+	// wish older than stored history changes pity of everything after it, stats are computed again then
+	bool recompute = false;
+	long long groupTime = -1;
+	long long seq = 0;
+	for (auto &element : wishes)
+	{
+		const compactWish &wish = asCompactWish(element);
+		if (wish.time < 0)
 		{
-			// There was error - what now?
-			std::cout << "Version error, what now?\n";
+			std::cout << "Error: skipping wish " << StringInterner::getInstance().name(wish.itemId) << " (invalid date)" << std::endl;
+			continue;
+		}
+		int itemId = getItemId(wish.itemId, wish.itemType);
+		if (itemId < 0)
+		{
+			std::cout << "error: can't store item " << StringInterner::getInstance().name(wish.itemId) << std::endl;
+			return rollback();
+		}
 
+		if (wish.time == groupTime)
+		{
+			seq++;
+		}
+		else if (idempotent)
+		{
+			groupTime = wish.time;
+			seq = 0;
 		}
 		else
 		{
-			if (g_version > version)
+			// one lookup per 10-pull, served by the key index
+			groupTime = wish.time;
+			sqlite3_bind_int64(nextSeqStmt, 1, wish.time);
+			seq = sqlite3_step(nextSeqStmt) == SQLITE_ROW ? sqlite3_column_int64(nextSeqStmt, 0) : 0;
+			sqlite3_reset(nextSeqStmt);
+		}
+
+		std::uint64_t key = 0;
+		bool hasKey = packWishKey(wish.time, itemId, seq, key);
+		if (idempotent && hasKey && storedKeys[bannerIndex].contains(key))
+		{
+			continue;
+		}
+
+		sqlite3_bind_int(stmt, 1, itemId);
+		sqlite3_bind_int64(stmt, 2, wish.time);
+		sqlite3_bind_int(stmt, 3, wish.itemRarity);
+		sqlite3_bind_int64(stmt, 4, seq);
+		if (sqlite3_step(stmt) != SQLITE_DONE)
+		{
+			// nothing of the batch is kept, so callers never see half of it as stored
+			std::cout << "error: " << sqlite3_errmsg(connectionHandle) << std::endl;
+			sqlite3_reset(stmt);
+			return rollback();
+		}
+		if (sqlite3_changes(connectionHandle) > 0)
+		{
+			inserted++;
+			if (collect)
 			{
-				// upgrade
-				std::cout << "Upgrade...\n";
+				collected.push_back(wish);
 			}
-			else if (g_version < version)
+			if (hasKey && storedKeysLoaded[bannerIndex])
 			{
-				// database version is higher than app, we cannot handle that so terminate
-				std::cout << "Terminate...\n";
-				exit(1);
+				storedKeys[bannerIndex].insert(key);
+			}
+			wishMark mark{ wish.time, seq };
+			if (latestMarksLoaded[bannerIndex] && latestMarks[bannerIndex] < mark)
+			{
+				latestMarks[bannerIndex] = mark;
+				stats[bannerIndex].add(wish.itemRarity, wish.time);
 			}
 			else
 			{
-				// version matches, we can proceed
-				std::cout << "Version matches!\n";
+				recompute = true;
 			}
 		}
+		sqlite3_reset(stmt);
 	}
-	else
+
+	if (inserted > 0 && ((recompute && !recomputeStats(banner)) || !saveStats(banner)))
 	{
-		// Didn't find systemInfo, we assume that it must be empty db
-		// Let's create all the required tables
-		createTables();
+		return rollback();
+	}
+
+	if (!executeCommand("COMMIT;"))
+	{
+		return rollback();
+	}
+	publishChanges();
+	if (!collected.empty())
+	{
+		changeFeed->publish(wishBatch{ banner, -1, -1, std::move(collected) });
 	}
+	return true;
+}
 
+size_t SQLDatabase::subscribe(std::function<void(const wishBatch&)> callback)
+{
+	return changeFeed->subscribe(std::move(callback));
 }
 
-void SQLDatabase::getTables(std::unordered_set<std::string> &tables)
+void SQLDatabase::unsubscribe(size_t subscription)
 {
-	sqlite3_stmt* stmt;
-	const char* sql = "SELECT * FROM sqlite_master WHERE type='table';";
-	int rc = sqlite3_prepare_v2(connectionHandle, sql, -1, &stmt, NULL);
+	changeFeed->unsubscribe(subscription);
+}
 
-	if (rc != SQLITE_OK) {
-		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+// Rows committed since last call are read back by their rowid range, nothing is read if nobody listens
+void SQLDatabase::publishChanges()
+{
+	auto committed = changeFeed->takeCommitted();
+	if (!changeFeed->hasSubscribers())
+	{
 		return;
 	}
 
-	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+	for (Banner banner : g_banners)
 	{
-		// Convert const unsigned char* to const char*. 
-		// People typically use an (unsigned char *) type to indicate that the data is binary and not plain ASCII text.
-		// Meaning you might need some encoding/decoding here, if data is UTF-8 symbol? With ICU library?
-		// Example of expected row:
-		// table|systemInfo|systemInfo|2|CREATE TABLE systemInfo (...)
-		const char* p = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-		if (p == NULL)
-			p = "";
-		tables.insert(std::string(p));
+		const ChangeFeed::rowRange &range = committed[static_cast<size_t>(banner)];
+		sqlite3_stmt* stmt = range.empty() ? nullptr : bannerStatement(banner, SelectWishRange);
+		if (!stmt)
+		{
+			continue;
+		}
+		wishBatch batch{ banner, range.first, range.last, {} };
+		batch.wishes.reserve(static_cast<size_t>(range.last - range.first + 1));
+		sqlite3_bind_int64(stmt, 1, range.first);
+		sqlite3_bind_int64(stmt, 2, range.last);
+		readCompactWishes(stmt, batch.wishes);
+		changeFeed->publish(batch);
 	}
+}
 
-	if (rc != SQLITE_DONE) {
+// Reads keys of every stored wish once, later writes keep them up to date
+bool SQLDatabase::loadStoredKeys(Banner banner)
+{
+	size_t bannerIndex = static_cast<size_t>(banner);
+	if (storedKeysLoaded[bannerIndex])
+	{
+		return true;
+	}
+
+	sqlite3_stmt* stmt;
+	int rc = sqlite3_prepare_v2(connectionHandle, sqlFor(banner).selectKeys, -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
 		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return false;
+	}
+
+	auto &keys = storedKeys[bannerIndex];
+	keys.clear();
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+	{
+		std::uint64_t key;
+		if (packWishKey(sqlite3_column_int64(stmt, 0), sqlite3_column_int64(stmt, 2), sqlite3_column_int64(stmt, 1), key))
+		{
+			keys.insert(key);
+		}
 	}
 	sqlite3_finalize(stmt);
+
+	storedKeysLoaded[bannerIndex] = rc == SQLITE_DONE;
+	return storedKeysLoaded[bannerIndex];
 }
 
-int SQLDatabase::infoTableGetLatestVersion()
+// Cached marks are read from db again on next latestWish call
+wishMark SQLDatabase::latestWish(Banner banner)
 {
-	sqlite3_stmt* stmt;
-	const char* sql = "SELECT version FROM systemInfo";
-	int rc = sqlite3_prepare_v2(connectionHandle, sql, -1, &stmt, NULL);
-	int version = 0;
+	dropStaleCaches();
+	size_t bannerIndex = static_cast<size_t>(banner);
+	if (latestMarksLoaded[bannerIndex])
+	{
+		return latestMarks[bannerIndex];
+	}
 
+	sqlite3_stmt* stmt;
+	int rc = sqlite3_prepare_v2(connectionHandle, sqlFor(banner).selectLatest, -1, &stmt, NULL);
 	if (rc != SQLITE_OK) {
 		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
-		return version;
+		return wishMark{};
 	}
 
-	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-		int id = sqlite3_column_int(stmt, 0);
-		std::cout << id;
-		if (id > version)
-			version = id;
+	// Walks key index backwards, so it's one row read no matter how big the table is
+	wishMark mark;
+	rc = sqlite3_step(stmt);
+	if (rc == SQLITE_ROW)
+	{
+		mark = wishMark{ sqlite3_column_int64(stmt, 0), sqlite3_column_int64(stmt, 1) };
 	}
+	sqlite3_finalize(stmt);
 
-	if (rc != SQLITE_DONE) {
+	if (rc == SQLITE_ROW || rc == SQLITE_DONE)
+	{
+		latestMarks[bannerIndex] = mark;
+		latestMarksLoaded[bannerIndex] = true;
+	}
+	else
+	{
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+	}
+	return mark;
+}
+
+void SQLDatabase::clearBannerCaches()
+{
+	for (size_t i = 0; i < g_bannerCount; i++)
+	{
+		storedKeys[i].clear();
+		storedKeysLoaded[i] = false;
+		latestMarks[i] = wishMark{};
+		latestMarksLoaded[i] = false;
+		stats[i] = wishStats{};
+		statsLoaded[i] = false;
+	}
+}
+
+// Keys, marks and stats of another connection's commit are not in the caches, they are read again after it
+void SQLDatabase::dropStaleCaches()
+{
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(connectionHandle, "PRAGMA data_version;", -1, &stmt, NULL) != SQLITE_OK)
+	{
 		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		clearBannerCaches();
+		return;
 	}
+	long long version = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : -1;
 	sqlite3_finalize(stmt);
 
-	return version;
+	if (version < 0 || version != dataVersion)
+	{
+		clearBannerCaches();
+	}
+	dataVersion = version;
 }
 
-void SQLDatabase::createTables()
+wishStats SQLDatabase::getStats(Banner banner)
 {
-	createInfoTable();
-	createWishTable();
+	dropStaleCaches();
+	loadStats(banner);
+	return stats[static_cast<size_t>(banner)];
 }
 
-void SQLDatabase::createInfoTable()
+// Banner without a bannerStats row has no wishes yet
+bool SQLDatabase::loadStats(Banner banner)
 {
-	char* errMsg = 0;
-	std::string command = "CREATE TABLE IF NOT EXISTS systemInfo (creationDate date DEFAULT CURRENT_TIMESTAMP,"
-		"version integer NOT NULL PRIMARY KEY);";
-	sqlite3_exec(connectionHandle, command.c_str(), callback, 0, &errMsg);
+	size_t bannerIndex = static_cast<size_t>(banner);
+	if (statsLoaded[bannerIndex])
+	{
+		return true;
+	}
 
-	command = "INSERT INTO systemInfo (version) VALUES (" + std::to_string(g_version) + ");";
-	auto rc = sqlite3_exec(connectionHandle, command.c_str(), callback, 0, &errMsg);
+	sqlite3_stmt* stmt;
+	const char* sql = "SELECT total, count3, count4, count5, pity4, pity5, last5Time FROM bannerStats WHERE banner = ?;";
+	int rc = sqlite3_prepare_v2(connectionHandle, sql, -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return false;
+	}
+	sqlite3_bind_int(stmt, 1, static_cast<int>(bannerIndex));
 
-	if (rc != SQLITE_OK)
+	wishStats loaded;
+	rc = sqlite3_step(stmt);
+	if (rc == SQLITE_ROW)
 	{
-		// error occured
-		std::cout << "Error: " << errMsg << std::endl;
+		loaded = wishStats{ sqlite3_column_int64(stmt, 0), sqlite3_column_int64(stmt, 1), sqlite3_column_int64(stmt, 2),
+			sqlite3_column_int64(stmt, 3), sqlite3_column_int64(stmt, 4), sqlite3_column_int64(stmt, 5), sqlite3_column_int64(stmt, 6) };
 	}
-	std::cout << "created Info Table\n";
+	sqlite3_finalize(stmt);
+
+	if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+	{
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return false;
+	}
+	stats[bannerIndex] = loaded;
+	statsLoaded[bannerIndex] = true;
+	return true;
 }
 
-void SQLDatabase::createWishTable()
+// Full scan of one banner in pull order (inside sqlite, see selectStats), only for migration and out of order inserts
+bool SQLDatabase::recomputeStats(Banner banner)
 {
-	char* errMsg = 0;
-	std::vector<std::string> commands = { "BEGIN;",
-		"CREATE TABLE IF NOT EXISTS wishCharacter(id integer PRIMARY KEY AUTOINCREMENT, itemType text"
-		" NOT NULL, itemName text NOT NULL, timeReceived date NOT NULL, itemRarity integer NOT NULL);",
-		"CREATE TABLE IF NOT EXISTS wishWeapon (id integer PRIMARY KEY AUTOINCREMENT, itemType text"
-		" NOT NULL, itemName text NOT NULL, timeReceived date NOT NULL, itemRarity integer NOT NULL);",
-		"CREATE TABLE IF NOT EXISTS wishStandard (id integer PRIMARY KEY AUTOINCREMENT, itemType text"
-		" NOT NULL, itemName text NOT NULL, timeReceived date NOT NULL, itemRarity integer NOT NULL);",
-		"CREATE TABLE IF NOT EXISTS wishBeginner (id integer PRIMARY KEY AUTOINCREMENT, itemType text"
-		" NOT NULL, itemName text NOT NULL, timeReceived date NOT NULL, itemRarity integer NOT NULL);",
-		"COMMIT;" };
-	for (auto &stmt : commands)
-	{
-		int rc = sqlite3_exec(connectionHandle, stmt.c_str(), callback, 0, &errMsg);
-		if (rc != SQLITE_OK)
-		{
-			// error occured
-			std::cout << "Error: " << errMsg << std::endl;
-		}
+	sqlite3_stmt* stmt;
+	int rc = sqlite3_prepare_v2(connectionHandle, sqlFor(banner).selectStats, -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return false;
 	}
-	std::cout << "created Wish Table\n";
+
+	// Empty table returns no row
+	wishStats computed;
+	rc = sqlite3_step(stmt);
+	if (rc == SQLITE_ROW)
+	{
+		computed = wishStats{ sqlite3_column_int64(stmt, 0), sqlite3_column_int64(stmt, 1), sqlite3_column_int64(stmt, 2),
+			sqlite3_column_int64(stmt, 3), sqlite3_column_int64(stmt, 4), sqlite3_column_int64(stmt, 5), sqlite3_column_int64(stmt, 6) };
+	}
+	sqlite3_finalize(stmt);
+
+	if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+	{
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return false;
+	}
+	size_t bannerIndex = static_cast<size_t>(banner);
+	stats[bannerIndex] = computed;
+	statsLoaded[bannerIndex] = true;
+	return true;
 }
 
-void SQLDatabase::executeCommand(std::string command)
+// Has to run inside transaction that changed the wishes
+bool SQLDatabase::saveStats(Banner banner)
 {
-	/*
-	sqlite3_stmt* stmt;
+	const wishStats &s = stats[static_cast<size_t>(banner)];
+	return executeCommand("INSERT OR REPLACE INTO bannerStats (banner, total, count3, count4, count5, pity4, pity5, last5Time) VALUES (" +
+		std::to_string(static_cast<int>(banner)) + ", " + std::to_string(s.total) + ", " + std::to_string(s.count3) + ", " +
+		std::to_string(s.count4) + ", " + std::to_string(s.count5) + ", " + std::to_string(s.pity4) + ", " +
+		std::to_string(s.pity5) + ", " + std::to_string(s.last5Time) + ");");
+}
 
-	int ret = sqlite3_prepare_v2(connectionHandle, command.c_str(), -1, &stmt, NULL);
-	if (ret != SQLITE_OK) 
+// Returns items.id for interned item name and type, inserting it into items table if needed
+// Returns -1 on error
+int SQLDatabase::getItemId(std::uint32_t nameId, wishItemType type)
+{
+	std::uint64_t key = (static_cast<std::uint64_t>(nameId) << 8) | static_cast<std::uint8_t>(type);
+	auto it = itemIds.find(key);
+	if (it != itemIds.end())
 	{
-		std::cout << "error: " << sqlite3_errmsg(connectionHandle) << std::endl;
-		return;
+		return it->second;
 	}
 
-	while ((ret = sqlite3_step(stmt)) == SQLITE_ROW) {
-		int id = sqlite3_column_int(stmt, 0);
-		const char* name = sqlite3_column_text(stmt, 1);
-		// ...
+	const std::string &itemName = StringInterner::getInstance().name(nameId);
+	sqlite3_stmt* stmt;
+	const char* sql = "SELECT id FROM items WHERE itemName = ? AND itemType = ?;";
+	int rc = sqlite3_prepare_v2(connectionHandle, sql, -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return -1;
 	}
-	if (ret != SQLITE_DONE) {
-		print("error: ", sqlite3_errmsg(db));
+	sqlite3_bind_text(stmt, 1, itemName.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_int(stmt, 2, static_cast<int>(type));
+
+	int id = -1;
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+	{
+		id = sqlite3_column_int(stmt, 0);
 	}
 	sqlite3_finalize(stmt);
-	*/
+
+	if (id < 0)
+	{
+		sql = "INSERT INTO items(itemType, itemName) VALUES(?, ?);";
+		rc = sqlite3_prepare_v2(connectionHandle, sql, -1, &stmt, NULL);
+		if (rc != SQLITE_OK) {
+			std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+			return -1;
+		}
+		sqlite3_bind_int(stmt, 1, static_cast<int>(type));
+		sqlite3_bind_text(stmt, 2, itemName.c_str(), -1, SQLITE_STATIC);
+		if (sqlite3_step(stmt) == SQLITE_DONE)
+		{
+			id = static_cast<int>(sqlite3_last_insert_rowid(connectionHandle));
+		}
+		else
+		{
+			std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		}
+		sqlite3_finalize(stmt);
+	}
+
+	if (id >= 0)
+	{
+		itemIds.emplace(key, id);
+		if (static_cast<size_t>(id) >= itemsById.size())
+		{
+			itemsById.resize(static_cast<size_t>(id) + 1);
+		}
+		itemsById[id] = itemInfo{ nameId, type };
+	}
+	return id;
+}
+
+// Reads whole items table into itemsById (and itemIds), items table is small - few hundred rows
+bool SQLDatabase::loadItems()
+{
+	sqlite3_stmt* stmt;
+	const char* sql = "SELECT id, itemType, itemName FROM items;";
+	int rc = sqlite3_prepare_v2(connectionHandle, sql, -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return false;
+	}
+
+	auto &interner = StringInterner::getInstance();
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+	{
+		int id = sqlite3_column_int(stmt, 0);
+		wishItemType type = static_cast<wishItemType>(sqlite3_column_int(stmt, 1));
+		const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+		if (id < 0 || !name)
+		{
+			continue;
+		}
+
+		std::uint32_t nameId = interner.intern(name);
+		if (static_cast<size_t>(id) >= itemsById.size())
+		{
+			itemsById.resize(static_cast<size_t>(id) + 1);
+		}
+		itemsById[id] = itemInfo{ nameId, type };
+		itemIds[(static_cast<std::uint64_t>(nameId) << 8) | static_cast<std::uint8_t>(type)] = id;
+	}
+	sqlite3_finalize(stmt);
+	return rc == SQLITE_DONE;
+}
+
+void SQLDatabase::clearItemCache()
+{
+	itemIds.clear();
+	itemsById.clear();
+}
+
+// Prepares statement on first use, returns nullptr (and prints error) if it can't be prepared
+// Statements are prepared after setupDB, so migrations never run under a cached statement
+sqlite3_stmt* SQLDatabase::bannerStatement(Banner banner, statementKind kind)
+{
+	sqlite3_stmt* &stmt = statements[static_cast<size_t>(banner)][kind];
+	if (stmt)
+	{
+		return stmt;
+	}
+
+	const bannerSql &sql = sqlFor(banner);
+	bool clustered = layout(banner) == wishTableLayout::Clustered;
+	const char* text = nullptr;
+	switch (kind)
+	{
+	case SelectWishes:
+		text = clustered ? sql.selectWishesInTimeOrder : sql.selectWishes;
+		break;
+	case SelectCompactWishes:
+		text = clustered ? sql.selectCompactWishesInTimeOrder : sql.selectCompactWishes;
+		break;
+	case InsertWish:
+		text = sql.insertWish;
+		break;
+	case ImportWish:
+		text = sql.importWish;
+		break;
+	case SelectNextSeq:
+		text = sql.selectNextSeq;
+		break;
+	default:
+		text = sql.selectWishRange;
+		break;
+	}
+	// PERSISTENT tells sqlite the statement is kept around, so it doesn't take memory from lookaside for it
+	if (sqlite3_prepare_v3(connectionHandle, text, -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL) != SQLITE_OK)
+	{
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		sqlite3_finalize(stmt);
+		stmt = nullptr;
+	}
+	return stmt;
+}
+
+void SQLDatabase::finalizeStatements()
+{
+	for (auto &bannerStatements : statements)
+	{
+		for (auto &stmt : bannerStatements)
+		{
+			sqlite3_finalize(stmt);
+			stmt = nullptr;
+		}
+	}
+}
+
+void SQLDatabase::init()
+{
+	// FULLMUTEX, backup/restore can run on another thread while this connection is used for writes
+	int ret = sqlite3_open_v2(dbFilename.c_str(), &connectionHandle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL);
+	if (ret != SQLITE_OK)
+	{
+		// error occured
+		return;
+	}
+
+	// WAL lets readers (SQLConnectionPool) run in parallel with each other and with our writes
+	char* errMsg = 0;
+	ret = sqlite3_exec(connectionHandle, "PRAGMA journal_mode=WAL;", callback, 0, &errMsg);
+	if (ret != SQLITE_OK)
+	{
+		// error occured
+		std::cout << "Error: " << errMsg << std::endl;
+	}
+
+	// Same as SQLITE_DEFAULT_WAL_SYNCHRONOUS=1 of our sqlite build, so system sqlite behaves the same
+	// In WAL mode NORMAL can lose last commits on power loss, but never corrupts db
+	executeCommand("PRAGMA synchronous=NORMAL;");
+
+	// pity() is used by recomputeStats, so functions have to exist before setupDB migrates anything
+	registerWishFunctions(connectionHandle);
+}
+
+void SQLDatabase::setupDB()
+{
+	// Fast path - files created or upgraded by this app carry our application_id and schema version
+	// in the db header, so one read is enough to know if db is ready
+	int applicationId = 0;
+	int version = 0;
+	readHeader(applicationId, version);
+	if (applicationId == g_applicationId && version > 0)
+	{
+		checkVersion(static_cast<unsigned int>(version));
+		return;
+	}
+
+	// Slow path for new files and files from before the header was used, search db for systemInfo table
+	if (hasTable("systemInfo"))
+	{
+		// We got systemInfo table, let's check it's latest version
+		version = infoTableGetLatestVersion();
+		if (version <= 0)
+		{
+			// There was error - what now?
+			std::cout << "Version error, what now?\n";
+			return;
+		}
+		checkVersion(static_cast<unsigned int>(version));
+	}
+	else
+	{
+		// Didn't find systemInfo, we assume that it must be empty db
+		// Let's create all the required tables
+		createTables();
+	}
+
+	// From now on this file takes the fast path
+	executeCommand("PRAGMA application_id = " + std::to_string(g_applicationId) + ";");
+	executeCommand("PRAGMA user_version = " + std::to_string(g_version) + ";");
+}
+
+void SQLDatabase::loadLayouts()
+{
+	for (Banner banner : g_banners)
+	{
+		layouts[static_cast<size_t>(banner)] = tableLayout(connectionHandle, banner);
+	}
+}
+
+// Table created WITHOUT ROWID is clustered, missing table counts as Rowid (default layout)
+wishTableLayout SQLDatabase::tableLayout(sqlite3* handle, Banner banner)
+{
+	sqlite3_stmt* stmt;
+	const char* sql = "SELECT sql LIKE '%WITHOUT ROWID%' FROM sqlite_schema WHERE type = 'table' AND name = ?;";
+	if (sqlite3_prepare_v2(handle, sql, -1, &stmt, NULL) != SQLITE_OK)
+	{
+		std::cout << "error: " << sqlite3_errmsg(handle);
+		return wishTableLayout::Rowid;
+	}
+	sqlite3_bind_text(stmt, 1, bannerTableName(banner), -1, SQLITE_STATIC);
+	bool clustered = sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0);
+	sqlite3_finalize(stmt);
+	return clustered ? wishTableLayout::Clustered : wishTableLayout::Rowid;
+}
+
+// Cached statements are finalized first, their text depends on layout and sqlite can't drop tables they read
+bool SQLDatabase::setLayout(wishTableLayout layout)
+{
+	finalizeStatements();
+	if (!executeCommand("BEGIN;"))
+	{
+		return false;
+	}
+	for (Banner banner : g_banners)
+	{
+		if (layouts[static_cast<size_t>(banner)] != layout && !rebuildWishTable(banner, layout))
+		{
+			executeCommand("ROLLBACK;");
+			loadLayouts();
+			return false;
+		}
+	}
+	if (!executeCommand("COMMIT;"))
+	{
+		executeCommand("ROLLBACK;");
+		loadLayouts();
+		return false;
+	}
+	layouts.fill(layout);
+	return true;
+}
+
+// Copy into new table, then it takes the place of the old one, keys stay the same so key caches stay valid
+// Rowid table gets ids in time order, so its insertion order matches time order right after rebuild
+bool SQLDatabase::rebuildWishTable(Banner banner, wishTableLayout layout)
+{
+	const bannerSql &sql = sqlFor(banner);
+	std::string table = sql.table;
+	std::string rebuilt = table + "_rebuilt";
+	std::string columns = layout == wishTableLayout::Clustered ? clusteredWishTableColumns.c_str() : wishTableColumns.c_str();
+	const std::vector<std::string> commands = {
+		"CREATE TABLE " + rebuilt + columns,
+		"INSERT INTO " + rebuilt + "(itemId, timeReceived, itemRarity, seq) SELECT itemId, timeReceived, itemRarity, seq FROM " +
+			table + " ORDER BY timeReceived, seq;",
+		"DROP TABLE " + table + ";",
+		"ALTER TABLE " + rebuilt + " RENAME TO " + table + ";" };
+	for (auto &command : commands)
+	{
+		if (!executeCommand(command))
+		{
+			return false;
+		}
+	}
+	// clustered table is its own key index
+	return layout == wishTableLayout::Clustered || executeCommand(sql.createKeyIndex);
+}
+
+// Compares db version with app version, upgrades db if it's older
+void SQLDatabase::checkVersion(unsigned int version)
+{
+	if (g_version > version)
+	{
+		// upgrade
+		std::cout << "Upgrade...\n";
+		if (!migrate(version))
+		{
+			// database is left at the last version that fully migrated, app can't work with it
+			std::cout << "Terminate...\n";
+			exit(1);
+		}
+	}
+	else if (g_version < version)
+	{
+		// database version is higher than app, we cannot handle that so terminate
+		std::cout << "Terminate...\n";
+		exit(1);
+	}
+	else
+	{
+		// version matches, we can proceed
+	}
+}
+
+// Reads application_id and user_version from db header in a single statement, both are 0 for new files
+void SQLDatabase::readHeader(int &applicationId, int &version)
+{
+	sqlite3_stmt* stmt;
+	const char* sql = "SELECT application_id, user_version FROM pragma_application_id, pragma_user_version;";
+	int rc = sqlite3_prepare_v2(connectionHandle, sql, -1, &stmt, NULL);
+
+	if (rc != SQLITE_OK) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return;
+	}
+
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+	{
+		applicationId = sqlite3_column_int(stmt, 0);
+		version = sqlite3_column_int(stmt, 1);
+	}
+	sqlite3_finalize(stmt);
+}
+
+bool SQLDatabase::hasTable(const std::string &tableName)
+{
+	sqlite3_stmt* stmt;
+	const char* sql = "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?;";
+	int rc = sqlite3_prepare_v2(connectionHandle, sql, -1, &stmt, NULL);
+
+	if (rc != SQLITE_OK) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return false;
+	}
+
+	sqlite3_bind_text(stmt, 1, tableName.c_str(), -1, SQLITE_STATIC);
+	bool found = sqlite3_step(stmt) == SQLITE_ROW;
+	sqlite3_finalize(stmt);
+	return found;
+}
+
+int SQLDatabase::infoTableGetLatestVersion()
+{
+	sqlite3_stmt* stmt;
+	const char* sql = "SELECT version FROM systemInfo";
+	int rc = sqlite3_prepare_v2(connectionHandle, sql, -1, &stmt, NULL);
+	int version = 0;
+
+	if (rc != SQLITE_OK) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+		return version;
+	}
+
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+		int id = sqlite3_column_int(stmt, 0);
+		if (id > version)
+			version = id;
+	}
+
+	if (rc != SQLITE_DONE) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle);
+	}
+	sqlite3_finalize(stmt);
+
+	return version;
+}
+
+// Ordered list of schema upgrades, step with version N migrates database from N - 1 to N
+// New schema version means new step at the end and g_version bump
+const std::vector<SQLDatabase::schemaMigration>& SQLDatabase::migrations()
+{
+	static const std::vector<schemaMigration> steps = {
+		{ 2, "items dictionary and epoch timestamps", &SQLDatabase::upgradeToV2 },
+		{ 3, "seq column and unique wish key", &SQLDatabase::upgradeToV3 },
+		{ 4, "bannerStats aggregates", &SQLDatabase::upgradeToV4 },
+	};
+	return steps;
+}
+
+// Runs every step newer than fromVersion, each in its own transaction.
+// Step, its systemInfo row and PRAGMA user_version are committed together, so file is never half-migrated.
+// Returns false if a step failed, database then stays at the version of the last successful step.
+bool SQLDatabase::migrate(unsigned int fromVersion)
+{
+	for (auto &step : migrations())
+	{
+		if (step.version <= fromVersion)
+		{
+			continue;
+		}
+
+		std::cout << "Upgrading to version " << step.version << " (" << step.description << ")\n";
+		if (!executeCommand("BEGIN IMMEDIATE;"))
+		{
+			return false;
+		}
+
+		bool ok = (this->*step.apply)() &&
+			executeCommand("INSERT INTO systemInfo (version) VALUES (" + std::to_string(step.version) + ");") &&
+			executeCommand("PRAGMA user_version = " + std::to_string(step.version) + ";") &&
+			executeCommand("COMMIT;");
+
+		if (!ok)
+		{
+			executeCommand("ROLLBACK;");
+			// item ids cached during failed step may not exist anymore
+			clearItemCache();
+			clearBannerCaches();
+			std::cout << "Upgrade to version " << step.version << " failed!\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+// Passes progress to callback given in constructor, or prints it if there is none
+void SQLDatabase::reportProgress(unsigned int version, const std::string &table, long long rowsDone, long long rowsTotal)
+{
+	if (progressCallback)
+	{
+		progressCallback(migrationProgress{ version, table, rowsDone, rowsTotal });
+	}
+	else
+	{
+		std::cout << "\t" << table << ": " << rowsDone << "/" << rowsTotal << "\n";
+	}
+}
+
+// Schema v1 -> v2
+// Item type and name move to items table and wish rows keep only itemId, dates become epoch seconds.
+// Rows are copied in batches of ids, so progress can be reported for big tables.
+// Dates that sqlite can't parse fail the step, rows are never copied with a made up time.
+bool SQLDatabase::upgradeToV2()
+{
+	std::vector<std::string> wishTables;
+	for (Banner banner : g_banners)
+	{
+		wishTables.push_back(bannerTableName(banner));
+	}
+	const std::string typeCase = "CASE w.itemType WHEN 'Character' THEN 1 WHEN 'Weapon' THEN 2 ELSE 0 END";
+	const long long batchSize = 10000;
+
+	createItemTable();
+	for (auto &table : wishTables)
+	{
+		if (!executeCommand("INSERT OR IGNORE INTO items(itemType, itemName) SELECT DISTINCT " + typeCase +
+			", w.itemName FROM " + table + " AS w;"))
+		{
+			return false;
+		}
+	}
+
+	for (auto &table : wishTables)
+	{
+		if (!executeCommand(wishTableSchema(table + "_v2")))
+		{
+			return false;
+		}
+
+		sqlite3_stmt* stmt;
+		long long maxId = 0;
+		long long rowsTotal = 0;
+		long long badDates = 0;
+		std::string command = "SELECT max(id), count(*), sum(strftime('%s', timeReceived) IS NULL) FROM " + table + ";";
+		if (sqlite3_prepare_v2(connectionHandle, command.c_str(), -1, &stmt, NULL) == SQLITE_OK)
+		{
+			if (sqlite3_step(stmt) == SQLITE_ROW)
+			{
+				maxId = sqlite3_column_int64(stmt, 0);
+				rowsTotal = sqlite3_column_int64(stmt, 1);
+				badDates = sqlite3_column_int64(stmt, 2);
+			}
+			sqlite3_finalize(stmt);
+		}
+		if (badDates > 0)
+		{
+			std::cout << "error: " << badDates << " wishes in " << table << " have a date that can't be parsed" << std::endl;
+			return false;
+		}
+
+		long long rowsDone = 0;
+		reportProgress(2, table, rowsDone, rowsTotal);
+		for (long long from = 0; from < maxId; from += batchSize)
+		{
+			command = "INSERT INTO " + table + "_v2(id, itemId, timeReceived, itemRarity) SELECT w.id, items.id, "
+				"CAST(strftime('%s', w.timeReceived) AS integer), w.itemRarity FROM " + table + " AS w "
+				"JOIN items ON items.itemName = w.itemName AND items.itemType = " + typeCase +
+				" WHERE w.id > " + std::to_string(from) + " AND w.id <= " + std::to_string(from + batchSize) + ";";
+			if (!executeCommand(command))
+			{
+				return false;
+			}
+			rowsDone += sqlite3_changes(connectionHandle);
+			reportProgress(2, table, rowsDone, rowsTotal);
+		}
+
+		if (!executeCommand("DROP TABLE " + table + ";") ||
+			!executeCommand("ALTER TABLE " + table + "_v2 RENAME TO " + table + ";"))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Schema v2 -> v3
+// Wishes get seq, their position among wishes with the same time, and (timeReceived, seq, itemId) becomes unique.
+// Existing rows are numbered in id order, so history imported twice before v3 stays as it was (seq 10 and up)
+// instead of failing the unique index.
+bool SQLDatabase::upgradeToV3()
+{
+	for (Banner banner : g_banners)
+	{
+		std::string table = bannerTableName(banner);
+		reportProgress(3, table, 0, 1);
+		if (!executeCommand("ALTER TABLE " + table + " ADD COLUMN seq integer NOT NULL DEFAULT 0;") ||
+			!executeCommand("UPDATE " + table + " SET seq = ranked.seq FROM (SELECT id, row_number() OVER"
+				" (PARTITION BY timeReceived ORDER BY id) - 1 AS seq FROM " + table + ") AS ranked"
+				" WHERE " + table + ".id = ranked.id;") ||
+			!executeCommand(sqlFor(banner).createKeyIndex))
+		{
+			return false;
+		}
+		reportProgress(3, table, 1, 1);
+	}
+	return true;
+}
+
+// Schema v3 -> v4
+// bannerStats is filled from existing history, from now on every insert keeps it up to date.
+bool SQLDatabase::upgradeToV4()
+{
+	if (!createStatsTable())
+	{
+		return false;
+	}
+
+	for (Banner banner : g_banners)
+	{
+		reportProgress(4, bannerTableName(banner), 0, 1);
+		if (!recomputeStats(banner) || !saveStats(banner))
+		{
+			return false;
+		}
+		reportProgress(4, bannerTableName(banner), 1, 1);
+	}
+	return true;
+}
+
+void SQLDatabase::createTables()
+{
+	createInfoTable();
+	createItemTable();
+	createWishTable();
+	createStatsTable();
+}
+
+void SQLDatabase::createInfoTable()
+{
+	char* errMsg = 0;
+	std::string command = "CREATE TABLE IF NOT EXISTS systemInfo (creationDate date DEFAULT CURRENT_TIMESTAMP,"
+		"version integer NOT NULL PRIMARY KEY);";
+	sqlite3_exec(connectionHandle, command.c_str(), callback, 0, &errMsg);
+
+	command = "INSERT INTO systemInfo (version) VALUES (" + std::to_string(g_version) + ");";
+	auto rc = sqlite3_exec(connectionHandle, command.c_str(), callback, 0, &errMsg);
+
+	if (rc != SQLITE_OK)
+	{
+		// error occured
+		std::cout << "Error: " << errMsg << std::endl;
+	}
+	std::cout << "created Info Table\n";
+}
+
+// Wish table layout of schema v2, used by upgradeToV2 only - current layout is sqlFor(banner).createTable
+std::string SQLDatabase::wishTableSchema(const std::string &tableName)
+{
+	return "CREATE TABLE IF NOT EXISTS " + tableName + " (id integer PRIMARY KEY AUTOINCREMENT, itemId integer"
+		" NOT NULL REFERENCES items(id), timeReceived integer NOT NULL, itemRarity integer NOT NULL);";
+}
+
+// One row per banner, banner is the Banner value
+bool SQLDatabase::createStatsTable()
+{
+	return executeCommand("CREATE TABLE IF NOT EXISTS bannerStats (banner integer PRIMARY KEY, total integer NOT NULL,"
+		" count3 integer NOT NULL, count4 integer NOT NULL, count5 integer NOT NULL, pity4 integer NOT NULL,"
+		" pity5 integer NOT NULL, last5Time integer NOT NULL);");
+}
+
+void SQLDatabase::createItemTable()
+{
+	executeCommand("CREATE TABLE IF NOT EXISTS items (id integer PRIMARY KEY, itemType integer NOT NULL,"
+		" itemName text NOT NULL, UNIQUE(itemName, itemType));");
+}
+
+void SQLDatabase::createWishTable()
+{
+	char* errMsg = 0;
+	std::vector<const char*> commands = { "BEGIN;" };
+	for (auto &sql : g_bannerSql)
+	{
+		commands.push_back(sql.createTable);
+		commands.push_back(sql.createKeyIndex);
+	}
+	commands.push_back("COMMIT;");
+	for (auto stmt : commands)
+	{
+		int rc = sqlite3_exec(connectionHandle, stmt, callback, 0, &errMsg);
+		if (rc != SQLITE_OK)
+		{
+			// error occured
+			std::cout << "Error: " << errMsg << std::endl;
+		}
+	}
+	std::cout << "created Wish Table\n";
+}
+
+void SQLDatabase::enableProfiling(std::chrono::microseconds slowThreshold)
+{
+	if (statementProfiler)
+	{
+		return;
+	}
+	statementProfiler = std::make_unique<SQLProfiler>(slowThreshold);
+	statementProfiler->attach(connectionHandle);
+}
+
+// Example usecase:		db.setBannerSchedule({ { Banner::Character, dateToEpoch("2020-09-28 10:00:00"), dateToEpoch("2020-10-18 15:00:00"), "Ballad in Goblets" } });
+bool SQLDatabase::setBannerSchedule(std::vector<bannerPeriod> periods)
+{
+	return ::setBannerSchedule(connectionHandle, std::move(periods));
+}
+
+bool SQLDatabase::attachColumns(const std::string &name, const WishColumns &columns)
+{
+	return registerColumnsTable(connectionHandle, name, columns);
+}
+
+bool SQLDatabase::detachColumns(const std::string &name)
+{
+	return unregisterColumnsTable(connectionHandle, name);
+}
+
+// Statements that would write are refused, writes go through insertWishes so caches stay right
+bool SQLDatabase::query(const std::string &sql, const std::function<void(sqlite3_stmt* row)> &visit)
+{
+	sqlite3_stmt* stmt;
+	int rc = sqlite3_prepare_v2(connectionHandle, sql.c_str(), -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle) << std::endl;
+		return false;
+	}
+	if (!sqlite3_stmt_readonly(stmt))
+	{
+		std::cout << "error: query has to be read-only: " << sql << std::endl;
+		sqlite3_finalize(stmt);
+		return false;
+	}
+
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+	{
+		visit(stmt);
+	}
+	sqlite3_finalize(stmt);
+	if (rc != SQLITE_DONE)
+	{
+		std::cout << "error: " << sqlite3_errmsg(connectionHandle) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Source is our own connection, so writes made through it between steps are copied into the running backup
+// instead of restarting it (which is what happens when another connection writes)
+bool SQLDatabase::backup(const std::string &path, int pagesPerStep, backupProgressCallback progress)
+{
+	sqlite3* target;
+	if (sqlite3_open(path.c_str(), &target) != SQLITE_OK)
+	{
+		std::cout << "error: " << sqlite3_errmsg(target);
+		sqlite3_close(target);
+		return false;
+	}
+
+	bool ok = copyDatabase(target, connectionHandle, pagesPerStep, progress);
+	sqlite3_close(target);
+	return ok;
+}
+
+// Every cache of this connection describes the old content, so they are dropped, setupDB then checks (and upgrades) the restored file
+bool SQLDatabase::restore(const std::string &path, int pagesPerStep, backupProgressCallback progress)
+{
+	sqlite3* source;
+	if (sqlite3_open_v2(path.c_str(), &source, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK)
+	{
+		std::cout << "error: " << sqlite3_errmsg(source);
+		sqlite3_close(source);
+		return false;
+	}
+
+	finalizeStatements();
+	clearItemCache();
+	clearBannerCaches();
+	bool ok = copyDatabase(connectionHandle, source, pagesPerStep, progress);
+	sqlite3_close(source);
+
+	if (ok)
+	{
+		setupDB();
+		loadLayouts();
+		// whole content was replaced, subscribers have to reload instead of getting rows of the upgrade
+		changeFeed->takeCommitted();
+	}
+	return ok;
+}
+
+// Copies pagesPerStep pages at a time, between steps lock on source is released and thread sleeps for a moment,
+// so writers waiting for the db get their turn
+bool SQLDatabase::copyDatabase(sqlite3* to, sqlite3* from, int pagesPerStep, const backupProgressCallback &progress)
+{
+	constexpr int yieldMs = 1;
+
+	sqlite3_backup* backup = sqlite3_backup_init(to, "main", from, "main");
+	if (!backup)
+	{
+		std::cout << "error: " << sqlite3_errmsg(to);
+		return false;
+	}
+
+	int rc;
+	do
+	{
+		rc = sqlite3_backup_step(backup, pagesPerStep);
+		if (progress)
+		{
+			int total = sqlite3_backup_pagecount(backup);
+			progress(backupProgress{ total - sqlite3_backup_remaining(backup), total });
+		}
+		if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+		{
+			sqlite3_sleep(yieldMs);
+		}
+	} while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+	sqlite3_backup_finish(backup);
+	if (rc != SQLITE_DONE)
+	{
+		std::cout << "error: " << sqlite3_errstr(rc);
+		return false;
+	}
+	return true;
+}
+
+// Executes command that doesn't return rows, prints error if there was one
+bool SQLDatabase::executeCommand(const std::string &command)
+{
+	char* errMsg = 0;
+	int rc = sqlite3_exec(connectionHandle, command.c_str(), callback, 0, &errMsg);
+	if (rc != SQLITE_OK)
+	{
+		// error occured
+		std::cout << "Error: " << (errMsg ? errMsg : sqlite3_errmsg(connectionHandle)) << std::endl;
+		sqlite3_free(errMsg);
+		return false;
+	}
+	return true;
+}
+
+compactWish toCompactWish(const wishEntry &wish)
+{
+	return compactWish{ dateToEpoch(wish.date), StringInterner::getInstance().intern(wish.itemName),
+		itemTypeFromString(wish.itemType), static_cast<std::uint8_t>(wish.itemRarity) };
+}
+
+wishEntry toWishEntry(const compactWish &wish)
+{
+	return wishEntry(itemTypeToString(wish.itemType), StringInterner::getInstance().name(wish.itemId),
+		epochToDate(wish.time), wish.itemRarity);
+}
+
+bool packWishKey(long long time, long long itemId, long long seq, std::uint64_t &key)
+{
+	if (time < 0 || time >= (1LL << 36) || itemId < 0 || itemId >= (1LL << 20) || seq < 0 || seq >= (1LL << 8))
+	{
+		return false;
+	}
+	key = (static_cast<std::uint64_t>(time) << 28) | (static_cast<std::uint64_t>(itemId) << 8) | static_cast<std::uint64_t>(seq);
+	return true;
+}
+
+// Default for backends that only store wishEntry
+// Keys use interned name ids here, seq is counted the same way as SQLDatabase does it
+size_t Database::importWishes(Banner banner, std::span<const wishEntry> wishes)
+{
+	std::vector<compactWish> stored;
+	getWishes(banner, stored);
+
+	std::unordered_set<std::uint64_t> keys;
+	long long groupTime = -1;
+	long long seq = 0;
+	for (auto &wish : stored)
+	{
+		seq = wish.time == groupTime ? seq + 1 : 0;
+		groupTime = wish.time;
+		std::uint64_t key;
+		if (packWishKey(wish.time, wish.itemId, seq, key))
+		{
+			keys.insert(key);
+		}
+	}
+
+	std::vector<wishEntry> newWishes;
+	groupTime = -1;
+	for (auto &wish : wishes)
+	{
+		compactWish compact = toCompactWish(wish);
+		seq = compact.time == groupTime ? seq + 1 : 0;
+		groupTime = compact.time;
+		std::uint64_t key;
+		if (!packWishKey(compact.time, compact.itemId, seq, key) || !keys.contains(key))
+		{
+			newWishes.push_back(wish);
+		}
+	}
+
+	size_t count = newWishes.size();
+	if (count > 0)
+	{
+		insertWishes(banner, std::move(newWishes));
+	}
+	return count;
+}
+
+void wishStats::add(unsigned int rarity, long long time)
+{
+	total++;
+	if (rarity == 3)
+		count3++;
+	else if (rarity == 4)
+		count4++;
+	else if (rarity == 5)
+		count5++;
+
+	pity4 = rarity >= 4 ? 0 : pity4 + 1;
+	pity5 = rarity >= 5 ? 0 : pity5 + 1;
+	if (rarity >= 5)
+	{
+		last5Time = time;
+	}
+}
+
+// Sorted by time, stable sort keeps wishes of one 10-pull in table order (their seq)
+wishStats Database::getStats(Banner banner)
+{
+	std::vector<compactWish> stored;
+	getWishes(banner, stored);
+	std::stable_sort(stored.begin(), stored.end(), [](const compactWish &a, const compactWish &b) { return a.time < b.time; });
+
+	wishStats computed;
+	for (auto &wish : stored)
+	{
+		computed.add(wish.itemRarity, wish.time);
+	}
+	return computed;
+}
+
+wishMark Database::latestWish(Banner banner)
+{
+	std::vector<compactWish> stored;
+	getWishes(banner, stored);
+
+	wishMark latest;
+	long long groupTime = -1;
+	long long seq = 0;
+	for (auto &wish : stored)
+	{
+		seq = wish.time == groupTime ? seq + 1 : 0;
+		groupTime = wish.time;
+		latest = std::max(latest, wishMark{ wish.time, seq });
+	}
+	return latest;
+}
+
+void Database::getWishes(Banner banner, std::vector<compactWish> &wishList)
+{
+	wishList.clear();
+	forEachWish(banner, [&](const wishEntry &wish) { wishList.push_back(toCompactWish(wish)); });
+}
+
+void Database::insertWishes(Banner banner, std::span<const compactWish> wishes)
+{
+	std::vector<wishEntry> converted;
+	converted.reserve(wishes.size());
+	for (auto &wish : wishes)
+	{
+		converted.push_back(toWishEntry(wish));
+	}
+	insertWishes(banner, std::move(converted));
+}
+
+bool Database::tryInsertWishes(Banner banner, std::span<const compactWish> wishes, size_t &inserted)
+{
+	std::vector<wishEntry> converted;
+	converted.reserve(wishes.size());
+	for (auto &wish : wishes)
+	{
+		converted.push_back(toWishEntry(wish));
+	}
+	return tryInsertWishes(banner, std::move(converted), inserted);
+}
+
+wishItemType itemTypeFromString(std::string_view type)
+{
+	if (type == "Character")
+		return wishItemType::Character;
+	if (type == "Weapon")
+		return wishItemType::Weapon;
+	return wishItemType::Unknown;
+}
+
+const char* itemTypeToString(wishItemType type)
+{
+	switch (type)
+	{
+	case wishItemType::Character:
+		return "Character";
+	case wishItemType::Weapon:
+		return "Weapon";
+	default:
+		return "Unknown";
+	}
+}
+
+// Example usecase:		dateToEpoch("2020-11-07 14:53:16") == 1604760796
+long long dateToEpoch(std::string_view date)
+{
+	// Expected format: YYYY-MM-DD HH:MM:SS
+	if (date.size() != 19 || date[4] != '-' || date[7] != '-' || date[10] != ' ' || date[13] != ':' || date[16] != ':')
+	{
+		return -1;
+	}
+
+	auto number = [&](size_t pos, size_t len) {
+		int value = 0;
+		for (size_t i = pos; i < pos + len; i++)
+		{
+			if (date[i] < '0' || date[i] > '9')
+				return -1;
+			value = value * 10 + (date[i] - '0');
+		}
+		return value;
+	};
+
+	int year = number(0, 4), month = number(5, 2), day = number(8, 2);
+	int hour = number(11, 2), minute = number(14, 2), second = number(17, 2);
+	if (year < 1970 || month < 0 || day < 0 || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59)
+	{
+		return -1;
+	}
+
+	std::chrono::year_month_day ymd{ std::chrono::year(year), std::chrono::month(month), std::chrono::day(day) };
+	if (!ymd.ok())
+	{
+		return -1;
+	}
+
+	long long days = std::chrono::sys_days(ymd).time_since_epoch().count();
+	return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+// Example usecase:		epochToDate(1604760796) == "2020-11-07 14:53:16"
+std::string epochToDate(long long epoch)
+{
+	std::string date;
+	epochToDate(epoch, date);
+	return date;
+}
+
+void epochToDate(long long epoch, std::string &date)
+{
+	long long days = epoch / 86400;
+	long long rest = epoch % 86400;
+	if (rest < 0)
+	{
+		days--;
+		rest += 86400;
+	}
+
+	std::chrono::year_month_day ymd{ std::chrono::sys_days(std::chrono::days(days)) };
+	char buffer[32];
+	int length = snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u %02lld:%02lld:%02lld", static_cast<int>(ymd.year()),
+		static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()), rest / 3600, (rest % 3600) / 60, rest % 60);
+	date.assign(buffer, length);
 }
 
 //int main()
@@ -2,12 +2,46 @@
 #define DATABASE_H
 
 #include <string>
-#include "sqlite3.h"
+#include <string_view>
+#include <cstdint>
+#include <sqlite3.h>
+#include "stringInterner.h"
+#include "bannerSql.h"
+#include "sqlProfiler.h"
+#include "sqlFunctions.h"
+#include "wishColumnsTable.h"
+#include <memory>
 #include <unordered_set>
+#include <unordered_map>
 #include <vector>
+#include <array>
+#include <span>
+#include <functional>
+#include <compare>
 
 constexpr char g_filename[] = "data.db";
-constexpr unsigned int g_version = 1;
+constexpr unsigned int g_version = 4;
+// Stored in db header (PRAGMA application_id) to recognize our files, "GWV1"
+constexpr int g_applicationId = 0x47575631;
+
+// Stored as small integer in items table (schema v2), text is used only at the API level
+enum class wishItemType : unsigned char
+{
+	Unknown = 0,
+	Character = 1,
+	Weapon = 2
+};
+
+wishItemType itemTypeFromString(std::string_view type);
+const char* itemTypeToString(wishItemType type);
+
+// Dates are "YYYY-MM-DD HH:MM:SS" at the API level and epoch seconds in the db (schema v2)
+// Game shows server time without zone, so it's converted as if it was UTC
+// dateToEpoch returns -1 if date can't be parsed
+long long dateToEpoch(std::string_view date);
+std::string epochToDate(long long epoch);
+// Writes into existing string, so its capacity is reused
+void epochToDate(long long epoch, std::string &date);
 
 struct wishEntry
 {
@@ -19,36 +53,291 @@ struct wishEntry
 	wishEntry(std::string t, std::string n, std::string d, unsigned int r) : itemType(t), itemName(n), date(d), itemRarity(r) {}
 };
 
+// Same wish without any heap allocation, for bulk loads and analytics
+// itemId comes from StringInterner::getInstance(), time is epoch seconds (-1 if date couldn't be parsed)
+struct compactWish
+{
+	long long time;
+	std::uint32_t itemId;
+	wishItemType itemType;
+	std::uint8_t itemRarity;
+};
+static_assert(sizeof(compactWish) <= 16, "compactWish should fit in 16 bytes");
+
+compactWish toCompactWish(const wishEntry &wish);
+wishEntry toWishEntry(const compactWish &wish);
+
+// Newest stored wish of a banner (high-water mark), time is -1 if banner has no wishes
+struct wishMark
+{
+	long long time = -1;
+	long long seq = 0;
+
+	auto operator<=>(const wishMark&) const = default;
+};
+
+// Aggregates of one banner, kept up to date on insert so viewer never scans history for them
+// Pity is number of pulls since last wish of at least that rarity, in order of time (and seq)
+struct wishStats
+{
+	long long total = 0;
+	long long count3 = 0;
+	long long count4 = 0;
+	long long count5 = 0;
+	long long pity4 = 0;
+	long long pity5 = 0;
+	// -1 if there was no 5 star yet
+	long long last5Time = -1;
+
+	// wish has to be newer than every wish added before
+	void add(unsigned int rarity, long long time);
+	bool operator==(const wishStats&) const = default;
+};
+
+// Natural key of a wish (time, item, seq) packed into 64 bits: 36 bits time, 20 bits item id, 8 bits seq
+// Returns false if some part doesn't fit, such wish can't be looked up by key
+bool packWishKey(long long time, long long itemId, long long seq, std::uint64_t &key);
+
+/*
+Interface of every wish storage.
+
+	getWishes replaces content of wishList, its capacity (and string capacity of existing elements) is reused,
+	so calling it repeatedly with the same vector doesn't allocate
+	inserts take a span, so callers never copy their data to pass it in
+	rvalue overload lets backends that keep wishEntry objects (in memory, async queue) take them without copying
+	importWishes is the idempotent insert, wishes already stored (same time, item and seq) are skipped,
+	so the same export or overlapping screenshots can be imported again without duplicating history
+	seq numbers wishes with the same time in the order they are passed, so import whole 10-pulls
+*/
 class Database
 {
 public:
 	virtual ~Database() {};
-	virtual void getWishes(std::string tableName, std::vector<wishEntry> &wishList) = 0;
-	virtual void insertWish(std::string tableName, wishEntry wish) = 0;
-	virtual void insertWishes(std::string tableName, std::vector<wishEntry> wishVec) = 0;
+	virtual void getWishes(Banner banner, std::vector<wishEntry> &wishList) = 0;
+	virtual void insertWishes(Banner banner, std::span<const wishEntry> wishes) = 0;
+	virtual void insertWishes(Banner banner, std::vector<wishEntry> &&wishes)
+	{
+		insertWishes(banner, std::span<const wishEntry>(wishes));
+	}
+	virtual void insertWish(Banner banner, const wishEntry &wish)
+	{
+		insertWishes(banner, std::span<const wishEntry>(&wish, 1));
+	}
+	// Same as insertWishes, but returns false if the wishes weren't stored (write was rolled back)
+	// and sets inserted to the number of wishes that were stored
+	// Default can't tell, it returns true and counts every wish, AsyncDatabase uses it to fail the futures of a batch that wasn't written
+	virtual bool tryInsertWishes(Banner banner, std::vector<wishEntry> &&wishes, size_t &inserted)
+	{
+		inserted = wishes.size();
+		insertWishes(banner, std::move(wishes));
+		return true;
+	}
+	// Returns number of wishes that were new, default reads the table and inserts only missing wishes
+	virtual size_t importWishes(Banner banner, std::span<const wishEntry> wishes);
+	// Time and seq of the newest stored wish, imports use it to stop at history that is already stored (see DeltaImport)
+	// Default reads the whole table, SQLDatabase keeps it cached
+	virtual wishMark latestWish(Banner banner);
+	// Default reads the whole table, SQLDatabase reads one row of bannerStats
+	virtual wishStats getStats(Banner banner);
+
+	// Compact variants, default converts to/from wishEntry, backends that store ids natively override them
+	virtual void getWishes(Banner banner, std::vector<compactWish> &wishList);
+	virtual void insertWishes(Banner banner, std::span<const compactWish> wishes);
+	virtual bool tryInsertWishes(Banner banner, std::span<const compactWish> wishes, size_t &inserted);
+
+	// Cursor over wish table, visits rows in table order without collecting them in a vector
+	// Default goes through getWishes, backends that can stream rows override it
+	virtual void forEachWish(Banner banner, const std::function<void(const wishEntry&)> &visit)
+	{
+		std::vector<wishEntry> wishList;
+		getWishes(banner, wishList);
+		for (auto &wish : wishList)
+		{
+			visit(wish);
+		}
+	}
+};
+
+// Reported while schema upgrade copies rows, table is empty for steps that don't copy rows
+struct migrationProgress
+{
+	unsigned int version;
+	std::string table;
+	long long rowsDone;
+	long long rowsTotal;
+};
+using migrationProgressCallback = std::function<void(const migrationProgress&)>;
+
+// Reported after every step of backup/restore
+struct backupProgress
+{
+	int pagesDone;
+	int pagesTotal;
+};
+using backupProgressCallback = std::function<void(const backupProgress&)>;
+
+// Storage of one wish table
+// Rowid: id integer PRIMARY KEY AUTOINCREMENT plus unique index on the natural key, getWishes returns insertion order
+// Clustered: WITHOUT ROWID table keyed by (timeReceived, seq, itemId), no id, no sqlite_sequence updates and no second index,
+// rows are stored in time order, so getWishes returns time order and time ranges are sequential page reads
+enum class wishTableLayout
+{
+	Rowid,
+	Clustered
 };
 
+class ChangeFeed;
+struct wishBatch;
+
 class SQLDatabase : public Database
 {
 public:
-	SQLDatabase(std::string dbF = g_filename);
+	SQLDatabase(std::string dbF = g_filename, migrationProgressCallback progress = nullptr);
 	~SQLDatabase() override;
-	void getWishes(std::string tableName, std::vector<wishEntry> &wishList) override;
-	void insertWish(std::string tableName, wishEntry wish) override;
-	void insertWishes(std::string tableName, std::vector<wishEntry> wishVec) override;
+	using Database::insertWishes;
+	void getWishes(Banner banner, std::vector<wishEntry> &wishList) override;
+	void insertWishes(Banner banner, std::span<const wishEntry> wishes) override;
+	void forEachWish(Banner banner, const std::function<void(const wishEntry&)> &visit) override;
+	void getWishes(Banner banner, std::vector<compactWish> &wishList) override;
+	void insertWishes(Banner banner, std::span<const compactWish> wishes) override;
+	bool tryInsertWishes(Banner banner, std::vector<wishEntry> &&wishes, size_t &inserted) override;
+	bool tryInsertWishes(Banner banner, std::span<const compactWish> wishes, size_t &inserted) override;
+	size_t importWishes(Banner banner, std::span<const wishEntry> wishes) override;
+	wishMark latestWish(Banner banner) override;
+	wishStats getStats(Banner banner) override;
+
+	// Online copy of the whole db to path (file is replaced), db stays usable while it runs
+	// Example usecase:		db.backup("backup/data-2023-05-01.db", 256, [](const backupProgress &p) { ... });
+	bool backup(const std::string &path, int pagesPerStep = 128, backupProgressCallback progress = nullptr);
+	// Replaces content of db with backup at path, upgrades it if the backup is older
+	// Restored wishes are not published to subscribers, they have to read the db again
+	bool restore(const std::string &path, int pagesPerStep = 128, backupProgressCallback progress = nullptr);
+
+	// Opt-in timing of every statement on this connection, summary is logged when db is closed
+	// Example usecase:		db.enableProfiling(std::chrono::milliseconds(20));
+	void enableProfiling(std::chrono::microseconds slowThreshold = std::chrono::milliseconds(100));
+	SQLProfiler* profiler() { return statementProfiler.get(); }
+	// Schedule of banner_of() on this connection, every connection also has epoch() and pity() (see sqlFunctions.h)
+	bool setBannerSchedule(std::vector<bannerPeriod> periods);
+	// In-memory columns as table name of this connection, until detached (see wishColumnsTable.h)
+	// Example usecase:		db.attachColumns("pending", columns); db.query("SELECT count(*) FROM pending WHERE rarity = 5;", ...);
+	bool attachColumns(const std::string &name, const WishColumns &columns);
+	bool detachColumns(const std::string &name);
+	// Ad-hoc read-only statement on this connection, visit is called for every row
+	bool query(const std::string &sql, const std::function<void(sqlite3_stmt* row)> &visit);
+	// Committed inserts are passed to callback right after COMMIT, on the thread that wrote them (see changeFeed.h)
+	// Example usecase:		size_t id = db.subscribe([&](const wishBatch &batch) { viewer.append(batch.banner, batch.wishes); });
+	size_t subscribe(std::function<void(const wishBatch&)> callback);
+	void unsubscribe(size_t subscription);
+
+	// Rebuilds wish tables whose layout differs, all of them in one transaction, rows are copied in time order
+	// Example usecase:		db.setLayout(wishTableLayout::Clustered);
+	bool setLayout(wishTableLayout layout);
+	wishTableLayout layout(Banner banner) const { return layouts[static_cast<size_t>(banner)]; }
+	// Reads layout from schema, for connections that aren't SQLDatabase (SQLConnectionPool)
+	static wishTableLayout tableLayout(sqlite3* handle, Banner banner);
+
+	// stmt is optional, already prepared selectWishes (or selectWishesInTimeOrder for clustered table) for handle
+	static void selectWishes(sqlite3* handle, Banner banner, std::vector<wishEntry> &wishList, sqlite3_stmt* stmt = nullptr);
+	static void selectWishes(sqlite3* handle, Banner banner, const std::function<void(const wishEntry&)> &visit, sqlite3_stmt* stmt = nullptr);
 private:
+	// Single schema upgrade, apply migrates database from version - 1 to version
+	// It runs inside transaction opened by migrate, so it shouldn't BEGIN/COMMIT on its own
+	struct schemaMigration
+	{
+		unsigned int version;
+		const char* description;
+		bool (SQLDatabase::*apply)();
+	};
+	static const std::vector<schemaMigration>& migrations();
+
 	void init();
 	void setupDB();
-	void getTables(std::unordered_set<std::string> &tables);
+	void checkVersion(unsigned int version);
+	void loadLayouts();
+	bool rebuildWishTable(Banner banner, wishTableLayout layout);
+	void readHeader(int &applicationId, int &version);
+	bool hasTable(const std::string &tableName);
 	int infoTableGetLatestVersion();
+	bool migrate(unsigned int fromVersion);
+	void reportProgress(unsigned int version, const std::string &table, long long rowsDone, long long rowsTotal);
+	bool upgradeToV2();
+	bool upgradeToV3();
+	bool upgradeToV4();
 	void createTables();
 	void createInfoTable();
+	void createItemTable();
 	void createWishTable();
+	bool createStatsTable();
+	bool loadStats(Banner banner);
+	bool recomputeStats(Banner banner);
+	bool saveStats(Banner banner);
+
+	// Row as sqlite returns it, itemName points into sqlite buffer and is valid only during the call
+	using wishRowVisitor = std::function<void(wishItemType type, std::string_view itemName, long long time, unsigned int rarity)>;
+	static void selectWishRows(sqlite3* handle, Banner banner, const wishRowVisitor &visit, sqlite3_stmt* stmt);
+	static void assignWish(wishEntry &wish, wishItemType type, std::string_view itemName, long long time, unsigned int rarity);
+
+	int getItemId(std::uint32_t nameId, wishItemType type);
+	bool loadItems();
+	void clearItemCache();
+	template <typename T>
+	bool writeWishes(Banner banner, std::span<const T> wishes, bool idempotent, size_t &inserted);
+	bool loadStoredKeys(Banner banner);
+	void clearBannerCaches();
+	void dropStaleCaches();
+
+	// Statements used on every read/write are prepared once per banner and kept until the db is closed
+	enum statementKind
+	{
+		SelectWishes,
+		SelectCompactWishes,
+		InsertWish,
+		ImportWish,
+		SelectNextSeq,
+		SelectWishRange,
+		statementKindCount
+	};
+	sqlite3_stmt* bannerStatement(Banner banner, statementKind kind);
+	void finalizeStatements();
+	// Steps selectCompactWishes-like stmt (itemId, timeReceived, itemRarity) and appends its rows, resolving items from cache
+	void readCompactWishes(sqlite3_stmt* stmt, std::vector<compactWish> &wishList);
+	void publishChanges();
+
+	static bool copyDatabase(sqlite3* to, sqlite3* from, int pagesPerStep, const backupProgressCallback &progress);
 
-	void executeCommand(std::string command);
+	static std::string wishTableSchema(const std::string &tableName);
+	bool executeCommand(const std::string &command);
 
 	sqlite3* connectionHandle;
 	std::string dbFilename;
+	migrationProgressCallback progressCallback;
+	// (interned name id << 8 | itemType) -> items.id, so inserts don't look up the same item twice
+	std::unordered_map<std::uint64_t, int> itemIds;
+	// items.id -> interned name id and type, so compact reads don't need to join items table
+	struct itemInfo
+	{
+		std::uint32_t nameId = StringInterner::npos;
+		wishItemType type = wishItemType::Unknown;
+	};
+	std::vector<itemInfo> itemsById;
+	// Packed keys (packWishKey with items.id) of every stored wish, loaded by first import into the banner
+	// Import skips wishes found here without asking sqlite, misses still go through ON CONFLICT DO NOTHING
+	std::array<std::unordered_set<std::uint64_t>, g_bannerCount> storedKeys;
+	std::array<bool, g_bannerCount> storedKeysLoaded{};
+	// latestWish of every banner, read once through the key index and then moved forward by writes
+	std::array<wishMark, g_bannerCount> latestMarks;
+	std::array<bool, g_bannerCount> latestMarksLoaded{};
+	// Copy of bannerStats rows, written back in the same transaction as the wishes that changed them
+	std::array<wishStats, g_bannerCount> stats;
+	std::array<bool, g_bannerCount> statsLoaded{};
+	// PRAGMA data_version when banner caches were last checked, it changes only when another connection commits
+	long long dataVersion = -1;
+	std::unique_ptr<SQLProfiler> statementProfiler;
+	std::array<wishTableLayout, g_bannerCount> layouts{};
+	// Installed after setupDB, so schema migrations are never published
+	std::unique_ptr<ChangeFeed> changeFeed;
+	std::array<std::array<sqlite3_stmt*, statementKindCount>, g_bannerCount> statements{};
 };
 
 class PostgreDatabase : public Database
@@ -56,9 +345,10 @@ class PostgreDatabase : public Database
 public:
 	PostgreDatabase() {};
 	~PostgreDatabase() override {};
-	void getWishes(std::string tableName, std::vector<wishEntry> &wishList) override {};
-	void insertWish(std::string tableName, wishEntry wish) override {};
-	void insertWishes(std::string tableName, std::vector<wishEntry> wishVec) override {};
+	using Database::getWishes;
+	using Database::insertWishes;
+	void getWishes(Banner banner, std::vector<wishEntry> &wishList) override {};
+	void insertWishes(Banner banner, std::span<const wishEntry> wishes) override {};
 };
 
 #endif /* DATABASE_H */
\ No newline at end of file
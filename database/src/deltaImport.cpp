@@ -0,0 +1,42 @@
+#include "deltaImport.h"
+#include <algorithm>
+
+// Mark is read once, db shouldn't get wishes of this banner from anywhere else until commit
+DeltaImport::DeltaImport(Database &db, Banner banner) : m_db(db), m_banner(banner), m_mark(db.latestWish(banner))
+{
+}
+
+// Returns false when wish is older than everything new, nothing after it needs to be read
+// Wishes with unparsable date are passed on, insert reports and skips them
+bool DeltaImport::add(const wishEntry &wish)
+{
+	if (m_done)
+	{
+		return false;
+	}
+
+	long long time = dateToEpoch(wish.date);
+	if (time >= 0 && time < m_mark.time)
+	{
+		m_done = true;
+		return false;
+	}
+
+	m_wishes.push_back(wish);
+	return true;
+}
+
+// Returns number of wishes that weren't stored yet
+size_t DeltaImport::commit()
+{
+	if (m_wishes.empty())
+	{
+		return 0;
+	}
+
+	std::reverse(m_wishes.begin(), m_wishes.end());
+	size_t inserted = m_db.importWishes(m_banner, m_wishes);
+	m_wishes.clear();
+	m_mark = m_db.latestWish(m_banner);
+	return inserted;
+}
@@ -0,0 +1,37 @@
+#ifndef DELTA_IMPORT_H
+#define DELTA_IMPORT_H
+
+#include "db.h"
+#include <vector>
+
+/*
+Incremental import of one banner, reads only history that isn't stored yet.
+
+	game history (and export files) list wishes newest first, importer passes them to add() in that order
+	add() returns false once it sees a wish older than latestWish of the banner, importer can stop reading
+	pages (OCR) or lines (file) right there, so weekly import costs as much as the new pulls, not the whole history
+	wishes with the same time as the stored mark are still taken, a 10-pull can be split between two pages
+	commit() inserts collected wishes oldest first through importWishes, so that overlap is skipped by its key
+*/
+
+class DeltaImport
+{
+public:
+	DeltaImport(Database &db, Banner banner);
+
+	// Example usecase:		while (ocr.nextWish(wish) && import.add(wish)) {}
+	bool add(const wishEntry &wish);
+	bool done() const { return m_done; }
+	size_t pending() const { return m_wishes.size(); }
+	size_t commit();
+
+private:
+	Database &m_db;
+	Banner m_banner;
+	wishMark m_mark;
+	bool m_done = false;
+	// newest first, as they were added
+	std::vector<wishEntry> m_wishes;
+};
+
+#endif /* DELTA_IMPORT_H */
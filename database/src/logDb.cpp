@@ -0,0 +1,812 @@
+#include "logDb.h"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+static_assert(sizeof(LogDatabase::fileHeader) == 16, "fileHeader is part of the file format");
+static_assert(sizeof(LogDatabase::logRecord) == 24, "logRecord is part of the file format");
+
+constexpr std::uint32_t g_logVersion = 1;
+constexpr char g_segmentMagic[4] = { 'G', 'W', 'V', 'L' };
+constexpr char g_itemsMagic[4] = { 'G', 'W', 'V', 'I' };
+constexpr size_t g_recordCrcBytes = offsetof(LogDatabase::logRecord, crc);
+
+// Entry of items.dict, followed by name and crc32 of both
+struct itemEntryHeader
+{
+	std::uint8_t type;
+	std::uint8_t reserved;
+	std::uint16_t length;
+};
+
+static LogDatabase::logRecord recordAt(const std::byte* data, size_t position)
+{
+	LogDatabase::logRecord record;
+	std::memcpy(&record, data + sizeof(LogDatabase::fileHeader) + position * sizeof(LogDatabase::logRecord), sizeof(record));
+	return record;
+}
+
+static bool validHeader(const std::byte* data, size_t size, const char (&magic)[4])
+{
+	if (size < sizeof(LogDatabase::fileHeader))
+	{
+		return false;
+	}
+	LogDatabase::fileHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	return std::memcmp(header.magic, magic, sizeof(header.magic)) == 0 && header.version == g_logVersion;
+}
+
+static bool writeHeader(AppendFile &file, const char (&magic)[4], std::uint64_t covered)
+{
+	LogDatabase::fileHeader header{};
+	std::memcpy(header.magic, magic, sizeof(header.magic));
+	header.version = g_logVersion;
+	header.covered = covered;
+	return file.append(&header, sizeof(header)) && file.sync();
+}
+
+// Maps can't stay open while file is truncated (Windows), caller opens it again
+static bool truncateFile(const std::string &path, size_t bytes)
+{
+	std::error_code error;
+	std::filesystem::resize_file(path, bytes, error);
+	if (error)
+	{
+		std::cout << "error: can't truncate " << path << ": " << error.message() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static const compactWish& asCompactWish(const compactWish &wish)
+{
+	return wish;
+}
+
+static compactWish asCompactWish(const wishEntry &wish)
+{
+	return toCompactWish(wish);
+}
+
+// LogDatabase constructor
+// Opens (or creates) every banner log in directory, recovering from a crash in the middle of a write
+LogDatabase::LogDatabase(std::string directory, size_t segmentBytes, size_t compactAfterSegments)
+	: m_directory(std::move(directory)), m_segmentBytes(segmentBytes), m_compactAfterSegments(compactAfterSegments)
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+	if (error)
+	{
+		std::cout << "error: can't create " << m_directory << ": " << error.message() << std::endl;
+		return;
+	}
+	if (!loadItems())
+	{
+		return;
+	}
+	for (Banner banner : g_banners)
+	{
+		openBanner(banner);
+	}
+}
+
+// Every write was synced when it returned, nothing is left to flush
+LogDatabase::~LogDatabase()
+{
+}
+
+// Reads items.dict, entry that is torn or fails crc ends the dictionary (it was the last write) and is cut off
+bool LogDatabase::loadItems()
+{
+	std::string path = m_directory + "/items.dict";
+	if (!m_itemFile.open(path))
+	{
+		return false;
+	}
+	if (m_itemFile.size() < sizeof(fileHeader))
+	{
+		// new dictionary, or crash while it was being created
+		m_itemFile.close();
+		return truncateFile(path, 0) && m_itemFile.open(path) && writeHeader(m_itemFile, g_itemsMagic, 0) && syncParentDirectory(path);
+	}
+
+	MappedFile map;
+	if (!map.open(path))
+	{
+		return false;
+	}
+	const std::byte* data = map.data();
+	size_t size = map.size();
+	if (!validHeader(data, size, g_itemsMagic))
+	{
+		std::cout << "error: " << path << " is not a wish item dictionary" << std::endl;
+		m_itemFile.close();
+		return false;
+	}
+
+	StringInterner &interner = StringInterner::getInstance();
+	size_t offset = sizeof(fileHeader);
+	while (offset + sizeof(itemEntryHeader) <= size)
+	{
+		itemEntryHeader entry;
+		std::memcpy(&entry, data + offset, sizeof(entry));
+		size_t entryBytes = sizeof(entry) + entry.length + sizeof(std::uint32_t);
+		if (offset + entryBytes > size)
+		{
+			break;
+		}
+		std::uint32_t crc;
+		std::memcpy(&crc, data + offset + sizeof(entry) + entry.length, sizeof(crc));
+		if (crc != crc32(data + offset, sizeof(entry) + entry.length))
+		{
+			break;
+		}
+
+		std::string_view name(reinterpret_cast<const char*>(data + offset + sizeof(entry)), entry.length);
+		itemInfo info{ interner.intern(name), static_cast<wishItemType>(entry.type) };
+		m_itemIds.emplace((static_cast<std::uint64_t>(info.nameId) << 8) | entry.type, static_cast<std::uint32_t>(m_items.size()));
+		m_items.push_back(info);
+		offset += entryBytes;
+	}
+
+	if (offset < size)
+	{
+		std::cout << "error: truncating torn tail of " << path << std::endl;
+		map.close();
+		m_itemFile.close();
+		if (!truncateFile(path, offset) || !m_itemFile.open(path))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Position of the item in items.dict, new item is appended (synced together with the records that use it)
+// Returns -1 if item can't be stored
+std::int64_t LogDatabase::itemFor(const compactWish &wish)
+{
+	std::uint64_t key = (static_cast<std::uint64_t>(wish.itemId) << 8) | static_cast<std::uint8_t>(wish.itemType);
+	auto it = m_itemIds.find(key);
+	if (it != m_itemIds.end())
+	{
+		return it->second;
+	}
+
+	const std::string &name = StringInterner::getInstance().name(wish.itemId);
+	if (name.size() > 0xFFFF || !m_itemFile.isOpen())
+	{
+		return -1;
+	}
+	itemEntryHeader entry{ static_cast<std::uint8_t>(wish.itemType), 0, static_cast<std::uint16_t>(name.size()) };
+	std::uint32_t crc = crc32(name.data(), name.size(), crc32(&entry, sizeof(entry)));
+	if (!m_itemFile.append(&entry, sizeof(entry)) || !m_itemFile.append(name.data(), name.size()) || !m_itemFile.append(&crc, sizeof(crc)))
+	{
+		return -1;
+	}
+
+	m_itemsDirty = true;
+	std::uint32_t position = static_cast<std::uint32_t>(m_items.size());
+	m_items.push_back(itemInfo{ wish.itemId, wish.itemType });
+	m_itemIds.emplace(key, position);
+	return position;
+}
+
+std::string LogDatabase::filePath(Banner banner, std::uint64_t number) const
+{
+	std::string path = m_directory + "/" + bannerTableName(banner);
+	if (number == 0)
+	{
+		return path + ".base";
+	}
+	// zero padded, so segments are listed in order
+	std::string digits = std::to_string(number);
+	if (digits.size() < 6)
+	{
+		digits.insert(0, 6 - digits.size(), '0');
+	}
+	return path + "." + digits + ".seg";
+}
+
+// Finds base and segments of the banner, checks them and builds the time index
+bool LogDatabase::openBanner(Banner banner)
+{
+	bannerLog &log = m_banners[static_cast<size_t>(banner)];
+	std::string table = bannerTableName(banner);
+	std::string basePath = filePath(banner, 0);
+
+	bool hasBase = false;
+	std::vector<std::pair<std::uint64_t, std::string>> segments;
+	std::error_code error;
+	for (auto &entry : std::filesystem::directory_iterator(m_directory, error))
+	{
+		std::string name = entry.path().filename().string();
+		if (name == table + ".base")
+		{
+			hasBase = true;
+		}
+		else if (name == table + ".base.tmp")
+		{
+			// compaction didn't finish, segments it was merging are still there
+			std::filesystem::remove(entry.path(), error);
+		}
+		else if (name.size() > table.size() + 5 && name.starts_with(table + ".") && name.ends_with(".seg"))
+		{
+			std::uint64_t number = 0;
+			const char* first = name.data() + table.size() + 1;
+			const char* last = name.data() + name.size() - 4;
+			auto result = std::from_chars(first, last, number);
+			if (result.ec == std::errc() && result.ptr == last && number > 0)
+			{
+				segments.emplace_back(number, entry.path().string());
+			}
+		}
+	}
+	std::sort(segments.begin(), segments.end());
+
+	std::uint64_t covered = 0;
+	if (hasBase)
+	{
+		logFile base;
+		base.path = basePath;
+		if (checkFile(base, segments.empty()))
+		{
+			fileHeader header;
+			std::memcpy(&header, base.map.data(), sizeof(header));
+			covered = header.covered;
+			log.files.push_back(std::move(base));
+		}
+	}
+	log.lastSegment = covered;
+
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		auto &[number, path] = segments[i];
+		if (number <= covered)
+		{
+			// merged into base by compaction that was interrupted before it deleted them
+			std::filesystem::remove(path, error);
+			continue;
+		}
+		logFile segment;
+		segment.path = path;
+		segment.number = number;
+		log.lastSegment = std::max(log.lastSegment, number);
+		if (checkFile(segment, i + 1 == segments.size()))
+		{
+			log.files.push_back(std::move(segment));
+		}
+	}
+
+	rebuildIndex(log);
+	if (!log.files.empty() && log.files.back().number != 0)
+	{
+		return log.active.open(log.files.back().path);
+	}
+	return true;
+}
+
+// Counts valid records of the file, last file of a banner is cut after its last good record (torn append),
+// bad records before a good one are damaged, not torn, they are kept and skipped by reads
+// Returns false if file can't be used, its records are not read then
+bool LogDatabase::checkFile(logFile &file, bool last)
+{
+	if (!file.map.open(file.path))
+	{
+		return false;
+	}
+	if (!validHeader(file.map.data(), file.map.size(), g_segmentMagic))
+	{
+		if (last && file.map.size() < sizeof(fileHeader))
+		{
+			// crash while the segment was being created, it has no records yet
+			file.map.close();
+			std::error_code error;
+			std::filesystem::remove(file.path, error);
+			return false;
+		}
+		std::cout << "error: " << file.path << " is not a wish log segment, skipping it" << std::endl;
+		file.map.close();
+		return false;
+	}
+
+	size_t records = (file.map.size() - sizeof(fileHeader)) / sizeof(logRecord);
+	bool torn = (file.map.size() - sizeof(fileHeader)) % sizeof(logRecord) != 0;
+	file.records = records;
+	std::vector<size_t> bad;
+	for (size_t i = 0; i < records; i++)
+	{
+		logRecord record = recordAt(file.map.data(), i);
+		if (record.crc != crc32(&record, g_recordCrcBytes) || record.item >= m_items.size())
+		{
+			bad.push_back(i);
+		}
+	}
+	// only the run of bad records at the very end can be an append that didn't finish
+	while (last && !bad.empty() && bad.back() + 1 == file.records)
+	{
+		file.records = bad.back();
+		bad.pop_back();
+		torn = true;
+	}
+	for (size_t i : bad)
+	{
+		std::cout << "error: damaged record " << i << " in " << file.path << ", skipping it" << std::endl;
+	}
+	file.damaged = std::move(bad);
+
+	if (torn)
+	{
+		std::cout << "error: truncating torn tail of " << file.path << " after " << file.records << " records" << std::endl;
+		file.map.close();
+		if (!truncateFile(file.path, sizeof(fileHeader) + file.records * sizeof(logRecord)))
+		{
+			return false;
+		}
+		return file.map.open(file.path);
+	}
+	return true;
+}
+
+// Records are indexed in file order, block is a run of at most indexBlockRecords positions in one file
+void LogDatabase::indexRecord(bannerLog &log, size_t file, size_t position, const logRecord &record)
+{
+	if (log.index.empty() || log.index.back().file != file || position - log.index.back().first >= indexBlockRecords)
+	{
+		log.index.push_back(timeBlock{ file, position, 1, record.time, record.time });
+	}
+	else
+	{
+		timeBlock &block = log.index.back();
+		block.count = position - block.first + 1;
+		block.minTime = std::min<long long>(block.minTime, record.time);
+		block.maxTime = std::max<long long>(block.maxTime, record.time);
+	}
+	log.latest = std::max(log.latest, wishMark{ record.time, record.seq });
+}
+
+void LogDatabase::rebuildIndex(bannerLog &log)
+{
+	log.index.clear();
+	log.latest = wishMark{};
+	for (size_t f = 0; f < log.files.size(); f++)
+	{
+		logFile &file = log.files[f];
+		const std::byte* data = fileData(file);
+		if (!data)
+		{
+			continue;
+		}
+		for (size_t i = 0; i < file.records; i++)
+		{
+			if (!file.damaged.empty() && std::binary_search(file.damaged.begin(), file.damaged.end(), i))
+			{
+				continue;
+			}
+			indexRecord(log, f, i, recordAt(data, i));
+		}
+	}
+}
+
+// Mapping is a snapshot, file that got records since it was mapped is mapped again
+const std::byte* LogDatabase::fileData(logFile &file)
+{
+	if (!file.map.isOpen() || file.map.size() < sizeof(fileHeader) + file.records * sizeof(logRecord))
+	{
+		file.map.open(file.path);
+	}
+	return file.map.data();
+}
+
+// Visits records with from <= time <= to in file order, blocks outside the range are skipped
+template <typename Visit>
+void LogDatabase::scan(bannerLog &log, const Visit &visit, long long from, long long to)
+{
+	for (auto &block : log.index)
+	{
+		if (block.maxTime < from || block.minTime > to)
+		{
+			continue;
+		}
+		logFile &file = log.files[block.file];
+		const std::byte* data = fileData(file);
+		if (!data)
+		{
+			continue;
+		}
+		for (size_t i = block.first; i < block.first + block.count; i++)
+		{
+			if (!file.damaged.empty() && std::binary_search(file.damaged.begin(), file.damaged.end(), i))
+			{
+				continue;
+			}
+			logRecord record = recordAt(data, i);
+			if (record.time >= from && record.time <= to)
+			{
+				visit(record);
+			}
+		}
+	}
+}
+
+// Seq for appending a wish with given time, continues after wishes already stored with the same time
+// New wishes are usually the newest, so latest answers it without reading any record
+long long LogDatabase::nextSeq(bannerLog &log, long long time)
+{
+	if (log.latest.time < time)
+	{
+		return 0;
+	}
+	if (log.latest.time == time)
+	{
+		return log.latest.seq + 1;
+	}
+	long long next = 0;
+	scan(log, [&](const logRecord &record) { next = std::max<long long>(next, record.seq + 1); }, time, time);
+	return next;
+}
+
+void LogDatabase::loadKeys(bannerLog &log)
+{
+	if (log.keysLoaded)
+	{
+		return;
+	}
+	log.keys.clear();
+	scan(log, [&](const logRecord &record) {
+		std::uint64_t key;
+		if (packWishKey(record.time, record.item, record.seq, key))
+		{
+			log.keys.insert(key);
+		}
+	});
+	log.keysLoaded = true;
+}
+
+bool LogDatabase::startSegment(Banner banner)
+{
+	bannerLog &log = m_banners[static_cast<size_t>(banner)];
+	log.active.close();
+	std::uint64_t number = log.lastSegment + 1;
+	std::string path = filePath(banner, number);
+	// segment nobody can find after power loss would lose every wish written to it
+	if (!log.active.open(path) || !writeHeader(log.active, g_segmentMagic, number) || !syncParentDirectory(path))
+	{
+		log.active.close();
+		return false;
+	}
+	log.lastSegment = number;
+	logFile segment;
+	segment.path = path;
+	segment.number = number;
+	log.files.push_back(std::move(segment));
+	return true;
+}
+
+// Appends wishes to the active segment with a single write and sync
+// Works for both wishEntry and compactWish, seq is assigned the same way as SQLDatabase does it:
+// appended wishes continue seq after wishes already stored with the same time,
+// idempotent (import) numbers them from 0 and skips those that are stored
+// inserted is the number of wishes that were written, returns false if they couldn't be written
+template <typename T>
+bool LogDatabase::writeWishes(Banner banner, std::span<const T> wishes, bool idempotent, size_t &inserted)
+{
+	inserted = 0;
+	bannerLog &log = m_banners[static_cast<size_t>(banner)];
+	if (idempotent)
+	{
+		loadKeys(log);
+	}
+
+	std::vector<logRecord> records;
+	records.reserve(wishes.size());
+	std::vector<std::uint64_t> newKeys;
+	// next seq of times this batch already wrote, they aren't in the index yet
+	std::unordered_map<long long, long long> batchSeq;
+	long long groupTime = -1;
+	long long seq = 0;
+	for (auto &element : wishes)
+	{
+		const compactWish &wish = asCompactWish(element);
+		// checked first, so rejected wish doesn't add its item to the dictionary
+		if (wish.time < 0)
+		{
+			std::cout << "Error: skipping wish " << StringInterner::getInstance().name(wish.itemId) << " (invalid date)" << std::endl;
+			continue;
+		}
+		std::int64_t item = itemFor(wish);
+		if (item < 0)
+		{
+			std::cout << "Error: skipping wish " << StringInterner::getInstance().name(wish.itemId) << " (item can't be stored)" << std::endl;
+			continue;
+		}
+
+		if (wish.time == groupTime)
+		{
+			seq++;
+		}
+		else
+		{
+			groupTime = wish.time;
+			if (idempotent)
+			{
+				seq = 0;
+			}
+			else
+			{
+				auto it = batchSeq.find(wish.time);
+				seq = it != batchSeq.end() ? it->second : nextSeq(log, wish.time);
+			}
+		}
+		if (!idempotent)
+		{
+			batchSeq[wish.time] = seq + 1;
+		}
+
+		std::uint64_t key = 0;
+		bool hasKey = packWishKey(wish.time, item, seq, key);
+		if (hasKey && log.keysLoaded)
+		{
+			// also skips a wish repeated within the batch
+			if (log.keys.insert(key).second)
+			{
+				newKeys.push_back(key);
+			}
+			else if (idempotent)
+			{
+				continue;
+			}
+		}
+
+		logRecord record{};
+		record.time = wish.time;
+		record.item = static_cast<std::uint32_t>(item);
+		record.seq = static_cast<std::uint32_t>(seq);
+		record.rarity = wish.itemRarity;
+		record.crc = crc32(&record, g_recordCrcBytes);
+		records.push_back(record);
+	}
+
+	if (records.empty())
+	{
+		return true;
+	}
+	// items used by the records are on disk first, so a stored record never refers to a missing item
+	bool written = !m_itemsDirty || m_itemFile.sync();
+	m_itemsDirty = m_itemsDirty && !written;
+	if (written && (!log.active.isOpen() || log.active.size() + records.size() * sizeof(logRecord) > m_segmentBytes))
+	{
+		// empty segment takes the batch even if it's bigger than segmentBytes
+		written = (log.active.isOpen() && log.active.size() <= sizeof(fileHeader)) || startSegment(banner);
+	}
+	size_t fileIndex = written ? log.files.size() - 1 : 0;
+	if (written)
+	{
+		written = log.active.append(records.data(), records.size() * sizeof(logRecord)) && log.active.sync();
+		if (!written)
+		{
+			// cut partial write off, so the next append starts at a record boundary
+			std::string path = log.active.path();
+			log.active.close();
+			log.files[fileIndex].map.close();
+			truncateFile(path, sizeof(fileHeader) + log.files[fileIndex].records * sizeof(logRecord));
+			log.active.open(path);
+		}
+	}
+	if (!written)
+	{
+		for (std::uint64_t key : newKeys)
+		{
+			log.keys.erase(key);
+		}
+		return false;
+	}
+
+	logFile &file = log.files[fileIndex];
+	size_t first = file.records;
+	file.records += records.size();
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		indexRecord(log, fileIndex, first + i, records[i]);
+	}
+
+	if (segmentCount(banner) > m_compactAfterSegments)
+	{
+		compact(banner);
+	}
+	inserted = records.size();
+	return true;
+}
+
+// Merges base and segments into a new base sorted by (time, seq)
+// New base is complete and synced before it replaces the old one, its header marks the segments as merged,
+// so crash at any point leaves either the old files or the new base (leftovers are deleted on open)
+bool LogDatabase::compact(Banner banner)
+{
+	bannerLog &log = m_banners[static_cast<size_t>(banner)];
+	if (log.files.empty() || (log.files.size() == 1 && log.files[0].number == 0 && log.files[0].damaged.empty()))
+	{
+		return true;
+	}
+
+	std::vector<logRecord> records;
+	records.reserve(count(banner));
+	scan(log, [&](const logRecord &record) { records.push_back(record); });
+	std::stable_sort(records.begin(), records.end(), [](const logRecord &a, const logRecord &b) {
+		return a.time != b.time ? a.time < b.time : a.seq < b.seq;
+	});
+
+	std::string basePath = filePath(banner, 0);
+	std::string tmpPath = basePath + ".tmp";
+	std::error_code error;
+	std::filesystem::remove(tmpPath, error);
+	{
+		AppendFile out;
+		bool written = out.open(tmpPath) && writeHeader(out, g_segmentMagic, log.lastSegment)
+			&& out.append(records.data(), records.size() * sizeof(logRecord)) && out.sync();
+		out.close();
+		if (!written)
+		{
+			std::filesystem::remove(tmpPath, error);
+			return false;
+		}
+	}
+
+	// Windows can't replace or delete files that are open or mapped
+	log.active.close();
+	for (auto &file : log.files)
+	{
+		file.map.close();
+	}
+	std::filesystem::rename(tmpPath, basePath, error);
+	if (error)
+	{
+		std::cout << "error: can't replace " << basePath << ": " << error.message() << std::endl;
+		std::filesystem::remove(tmpPath, error);
+		if (log.files.back().number != 0)
+		{
+			log.active.open(log.files.back().path);
+		}
+		return false;
+	}
+	// rename has to reach the disk before the segments it replaced are gone,
+	// if it can't be synced they stay (base covers them, next open deletes them)
+	bool synced = syncParentDirectory(basePath);
+	for (auto &file : log.files)
+	{
+		if (synced && file.number != 0)
+		{
+			std::filesystem::remove(file.path, error);
+		}
+	}
+
+	// next write starts a new segment after the covered ones
+	log.files.clear();
+	logFile base;
+	base.path = basePath;
+	base.records = records.size();
+	log.files.push_back(std::move(base));
+	rebuildIndex(log);
+	return synced;
+}
+
+size_t LogDatabase::count(Banner banner) const
+{
+	size_t total = 0;
+	for (auto &file : m_banners[static_cast<size_t>(banner)].files)
+	{
+		total += file.records - file.damaged.size();
+	}
+	return total;
+}
+
+size_t LogDatabase::blocksInRange(Banner banner, long long from, long long to) const
+{
+	auto &index = m_banners[static_cast<size_t>(banner)].index;
+	return static_cast<size_t>(std::count_if(index.begin(), index.end(), [&](const timeBlock &block) {
+		return block.maxTime >= from && block.minTime <= to;
+	}));
+}
+
+size_t LogDatabase::segmentCount(Banner banner) const
+{
+	auto &files = m_banners[static_cast<size_t>(banner)].files;
+	return static_cast<size_t>(std::count_if(files.begin(), files.end(), [](const logFile &file) { return file.number != 0; }));
+}
+
+void LogDatabase::getWishes(Banner banner, std::vector<compactWish> &wishList)
+{
+	wishList.clear();
+	wishList.reserve(count(banner));
+	scan(m_banners[static_cast<size_t>(banner)], [&](const logRecord &record) {
+		const itemInfo &item = m_items[record.item];
+		wishList.push_back(compactWish{ record.time, item.nameId, item.type, record.rarity });
+	});
+}
+
+// Elements already in wishList are overwritten in place, so their strings are reused
+void LogDatabase::getWishes(Banner banner, std::vector<wishEntry> &wishList)
+{
+	StringInterner &interner = StringInterner::getInstance();
+	size_t count = 0;
+	scan(m_banners[static_cast<size_t>(banner)], [&](const logRecord &record) {
+		const itemInfo &item = m_items[record.item];
+		if (count < wishList.size())
+		{
+			wishEntry &wish = wishList[count];
+			wish.itemType.assign(itemTypeToString(item.type));
+			wish.itemName.assign(interner.name(item.nameId));
+			epochToDate(record.time, wish.date);
+			wish.itemRarity = record.rarity;
+		}
+		else
+		{
+			wishList.emplace_back(itemTypeToString(item.type), interner.name(item.nameId), epochToDate(record.time), record.rarity);
+		}
+		count++;
+	});
+	wishList.erase(wishList.begin() + count, wishList.end());
+}
+
+// Only one wishEntry exists at a time
+void LogDatabase::forEachWish(Banner banner, const std::function<void(const wishEntry&)> &visit)
+{
+	StringInterner &interner = StringInterner::getInstance();
+	wishEntry wish("", "", "", 0);
+	scan(m_banners[static_cast<size_t>(banner)], [&](const logRecord &record) {
+		const itemInfo &item = m_items[record.item];
+		wish.itemType.assign(itemTypeToString(item.type));
+		wish.itemName.assign(interner.name(item.nameId));
+		epochToDate(record.time, wish.date);
+		wish.itemRarity = record.rarity;
+		visit(wish);
+	});
+}
+
+void LogDatabase::getWishesInRange(Banner banner, long long from, long long to, std::vector<compactWish> &wishList)
+{
+	wishList.clear();
+	scan(m_banners[static_cast<size_t>(banner)], [&](const logRecord &record) {
+		const itemInfo &item = m_items[record.item];
+		wishList.push_back(compactWish{ record.time, item.nameId, item.type, record.rarity });
+	}, from, to);
+}
+
+void LogDatabase::insertWishes(Banner banner, std::span<const wishEntry> wishes)
+{
+	size_t inserted;
+	writeWishes(banner, wishes, false, inserted);
+}
+
+void LogDatabase::insertWishes(Banner banner, std::span<const compactWish> wishes)
+{
+	size_t inserted;
+	writeWishes(banner, wishes, false, inserted);
+}
+
+bool LogDatabase::tryInsertWishes(Banner banner, std::vector<wishEntry> &&wishes, size_t &inserted)
+{
+	return writeWishes(banner, std::span<const wishEntry>(wishes), false, inserted);
+}
+
+bool LogDatabase::tryInsertWishes(Banner banner, std::span<const compactWish> wishes, size_t &inserted)
+{
+	return writeWishes(banner, wishes, false, inserted);
+}
+
+size_t LogDatabase::importWishes(Banner banner, std::span<const wishEntry> wishes)
+{
+	size_t inserted;
+	writeWishes(banner, wishes, true, inserted);
+	return inserted;
+}
+
+// Kept up to date by the index, nothing is read
+wishMark LogDatabase::latestWish(Banner banner)
+{
+	return m_banners[static_cast<size_t>(banner)].latest;
+}
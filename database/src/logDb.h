@@ -0,0 +1,158 @@
+#ifndef LOG_DATABASE_H
+#define LOG_DATABASE_H
+
+#include "db.h"
+#include "mappedFile.h"
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+Append-only wish storage without sqlite, for write heavy imports.
+
+	every banner is a sequence of segment files in directory: <table>.<n>.seg, new wishes are appended to the last one,
+	when it's bigger than segmentBytes a new segment is started
+	file starts with 16 byte header (magic, format version, covered segment), then fixed 24 byte records:
+	time, item, seq, rarity and crc32 of the record, so torn or damaged record is recognized on its own
+	item names are kept once in items.dict (same crc per entry), records refer to them by position
+	every write is synced before it returns, items.dict (when it got new items) before the records that use it
+	open checks every record, run of bad records at the end of the last segment (crash during append) is truncated,
+	damaged record elsewhere is reported and skipped
+	reads go through memory mapped segments, no read calls and no copies into our buffers
+	sparse time index: min/max time of every block of 256 records, range reads skip blocks outside the range
+	and seq lookups for older times only look into blocks that can contain the time
+	compaction merges base and all segments into <table>.base in time order (like setLayout of SQLDatabase),
+	it runs after a write once there are more than compactAfterSegments segments, or when called
+	base header says which segments it covers, so segments left behind by interrupted compaction are deleted on open
+	getWishes returns wishes in file order: base (time order) then segments (append order)
+	not thread safe, use it from one thread or through AsyncDatabase
+*/
+
+class LogDatabase : public Database
+{
+public:
+	// Example usecase:		LogDatabase db("wishlog"); db.importWishes(Banner::Character, wishes);
+	LogDatabase(std::string directory = "wishlog", size_t segmentBytes = 4 << 20, size_t compactAfterSegments = 8);
+	~LogDatabase() override;
+
+	// disable copy and move
+	LogDatabase(const LogDatabase&) = delete;
+	void operator=(const LogDatabase&) = delete;
+	LogDatabase(LogDatabase&&) = delete;
+	void operator=(LogDatabase&&) = delete;
+
+	using Database::getWishes;
+	using Database::insertWishes;
+	void getWishes(Banner banner, std::vector<wishEntry> &wishList) override;
+	void getWishes(Banner banner, std::vector<compactWish> &wishList) override;
+	void insertWishes(Banner banner, std::span<const wishEntry> wishes) override;
+	void insertWishes(Banner banner, std::span<const compactWish> wishes) override;
+	bool tryInsertWishes(Banner banner, std::vector<wishEntry> &&wishes, size_t &inserted) override;
+	bool tryInsertWishes(Banner banner, std::span<const compactWish> wishes, size_t &inserted) override;
+	size_t importWishes(Banner banner, std::span<const wishEntry> wishes) override;
+	wishMark latestWish(Banner banner) override;
+	void forEachWish(Banner banner, const std::function<void(const wishEntry&)> &visit) override;
+
+	// Wishes received between from and to (epoch seconds, both inclusive), in file order
+	void getWishesInRange(Banner banner, long long from, long long to, std::vector<compactWish> &wishList);
+	bool compact(Banner banner);
+	size_t count(Banner banner) const;
+	size_t segmentCount(Banner banner) const;
+	// Index blocks getWishesInRange reads for the range, the others are skipped without touching their records
+	size_t blocksInRange(Banner banner, long long from, long long to) const;
+
+	// On disk format, native byte order
+	struct fileHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		// base: highest segment number merged into it, segment: its own number
+		std::uint64_t covered;
+	};
+	struct logRecord
+	{
+		std::int64_t time;
+		std::uint32_t item;
+		std::uint32_t seq;
+		std::uint8_t rarity;
+		std::uint8_t reserved[3];
+		// crc32 of everything above
+		std::uint32_t crc;
+	};
+
+private:
+	static constexpr size_t indexBlockRecords = 256;
+
+	struct logFile
+	{
+		std::string path;
+		// 0 for base
+		std::uint64_t number = 0;
+		MappedFile map;
+		size_t records = 0;
+		// positions of damaged records found on open, skipped by reads
+		std::vector<size_t> damaged;
+	};
+	struct timeBlock
+	{
+		size_t file;
+		size_t first;
+		size_t count;
+		long long minTime;
+		long long maxTime;
+	};
+	struct bannerLog
+	{
+		// base first (if there is one), then segments by number
+		std::vector<logFile> files;
+		// highest segment number ever used, new segment gets the next one
+		std::uint64_t lastSegment = 0;
+		// open on files.back() if it's a segment
+		AppendFile active;
+		std::vector<timeBlock> index;
+		wishMark latest;
+		// packWishKey(time, item, seq) of every record, loaded by first import
+		std::unordered_set<std::uint64_t> keys;
+		bool keysLoaded = false;
+	};
+	struct itemInfo
+	{
+		std::uint32_t nameId;
+		wishItemType type;
+	};
+
+	bool loadItems();
+	std::int64_t itemFor(const compactWish &wish);
+	bool openBanner(Banner banner);
+	bool checkFile(logFile &file, bool last);
+	void indexRecord(bannerLog &log, size_t file, size_t position, const logRecord &record);
+	void rebuildIndex(bannerLog &log);
+	bool startSegment(Banner banner);
+	const std::byte* fileData(logFile &file);
+	template <typename Visit>
+	void scan(bannerLog &log, const Visit &visit, long long from = LLONG_MIN, long long to = LLONG_MAX);
+	long long nextSeq(bannerLog &log, long long time);
+	void loadKeys(bannerLog &log);
+	template <typename T>
+	bool writeWishes(Banner banner, std::span<const T> wishes, bool idempotent, size_t &inserted);
+	std::string filePath(Banner banner, std::uint64_t number) const;
+
+	const std::string m_directory;
+	const size_t m_segmentBytes;
+	const size_t m_compactAfterSegments;
+	std::array<bannerLog, g_bannerCount> m_banners;
+
+	AppendFile m_itemFile;
+	// items were appended since the last sync, next write syncs them before its records
+	bool m_itemsDirty = false;
+	// position in items.dict -> interned name and type
+	std::vector<itemInfo> m_items;
+	// (interned name id << 8 | itemType) -> position in items.dict
+	std::unordered_map<std::uint64_t, std::uint32_t> m_itemIds;
+};
+
+#endif /* LOG_DATABASE_H */
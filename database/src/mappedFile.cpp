@@ -0,0 +1,274 @@
+#include "mappedFile.h"
+#include <array>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile &&other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		m_open = std::exchange(other.m_open, false);
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+		m_file = std::exchange(other.m_file, nullptr);
+		m_mapping = std::exchange(other.m_mapping, nullptr);
+#else
+		m_fd = std::exchange(other.m_fd, -1);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+// FILE_SHARE_WRITE and FILE_SHARE_DELETE, so the file can still be appended to (and renamed) by AppendFile
+bool MappedFile::open(const std::string &path)
+{
+	close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "error: can't open " << path << std::endl;
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		std::cout << "error: can't read size of " << path << std::endl;
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_open = true;
+	m_size = static_cast<size_t>(size.QuadPart);
+	if (m_size == 0)
+	{
+		// empty file can't be mapped
+		return true;
+	}
+
+	m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void* view = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view)
+	{
+		std::cout << "error: can't map " << path << std::endl;
+		close();
+		return false;
+	}
+	m_data = static_cast<const std::byte*>(view);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (m_file)
+	{
+		CloseHandle(m_file);
+	}
+	m_data = nullptr;
+	m_mapping = nullptr;
+	m_file = nullptr;
+	m_size = 0;
+	m_open = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path)
+{
+	close();
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::cout << "error: can't open " << path << std::endl;
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		std::cout << "error: can't read size of " << path << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	m_fd = fd;
+	m_open = true;
+	m_size = static_cast<size_t>(info.st_size);
+	if (m_size == 0)
+	{
+		// mmap of 0 bytes fails
+		return true;
+	}
+
+	void* view = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED)
+	{
+		std::cout << "error: can't map " << path << std::endl;
+		close();
+		return false;
+	}
+	// records are read front to back
+	madvise(view, m_size, MADV_SEQUENTIAL);
+	m_data = static_cast<const std::byte*>(view);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		munmap(const_cast<std::byte*>(m_data), m_size);
+	}
+	if (m_fd >= 0)
+	{
+		::close(m_fd);
+	}
+	m_data = nullptr;
+	m_fd = -1;
+	m_size = 0;
+	m_open = false;
+}
+
+#endif
+
+bool AppendFile::open(const std::string &path)
+{
+	close();
+	m_file = std::fopen(path.c_str(), "ab");
+	if (!m_file)
+	{
+		std::cout << "error: can't open " << path << " for writing" << std::endl;
+		return false;
+	}
+	// append mode reports position 0 until the first write, so size is taken from the end
+	std::fseek(m_file, 0, SEEK_END);
+	long position = std::ftell(m_file);
+	m_size = position > 0 ? static_cast<size_t>(position) : 0;
+	m_path = path;
+	return true;
+}
+
+void AppendFile::close()
+{
+	if (m_file)
+	{
+		std::fclose(m_file);
+		m_file = nullptr;
+	}
+	m_size = 0;
+}
+
+bool AppendFile::append(const void* data, size_t bytes)
+{
+	if (!m_file || std::fwrite(data, 1, bytes, m_file) != bytes)
+	{
+		std::cout << "error: can't write to " << m_path << std::endl;
+		return false;
+	}
+	m_size += bytes;
+	return true;
+}
+
+bool AppendFile::sync()
+{
+	if (!m_file || std::fflush(m_file) != 0)
+	{
+		return false;
+	}
+#ifdef _WIN32
+	return _commit(_fileno(m_file)) == 0;
+#else
+	return fsync(fileno(m_file)) == 0;
+#endif
+}
+
+#ifdef _WIN32
+
+// NTFS journals directory changes itself, a directory can't be flushed without write access to it
+bool syncParentDirectory(const std::string&)
+{
+	return true;
+}
+
+#else
+
+bool syncParentDirectory(const std::string &path)
+{
+	size_t slash = path.find_last_of('/');
+	std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+	int fd = ::open(directory.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::cout << "error: can't open " << directory << std::endl;
+		return false;
+	}
+	bool synced = fsync(fd) == 0;
+	::close(fd);
+	if (!synced)
+	{
+		std::cout << "error: can't sync " << directory << std::endl;
+	}
+	return synced;
+}
+
+#endif
+
+// Table driven, table is built on first call
+std::uint32_t crc32(const void* data, size_t bytes, std::uint32_t crc)
+{
+	static const auto table = [] {
+		std::array<std::uint32_t, 256> entries{};
+		for (std::uint32_t i = 0; i < 256; i++)
+		{
+			std::uint32_t value = i;
+			for (int bit = 0; bit < 8; bit++)
+			{
+				value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+			}
+			entries[i] = value;
+		}
+		return entries;
+	}();
+
+	const std::uint8_t* bytesIn = static_cast<const std::uint8_t*>(data);
+	crc = ~crc;
+	for (size_t i = 0; i < bytes; i++)
+	{
+		crc = table[(crc ^ bytesIn[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
@@ -0,0 +1,88 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/*
+Files for storage that doesn't go through sqlite (LogDatabase, snapshots).
+
+	MappedFile maps whole file read-only (mmap, CreateFileMapping on Windows), data stays valid until close or destruction
+	mapping is a snapshot of the size at open, file that grew has to be opened again to see the new bytes
+	Windows can't delete or truncate a file while it's mapped, so close the mapping first
+	crc32 (zlib polynomial) checks records and headers of these files
+	AppendFile writes at the end of a file, sync() flushes it to the disk (fsync/_commit), so data survives power loss
+	new, renamed or deleted file is only durable once its directory is synced too (syncParentDirectory)
+*/
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	// move only, mapping has one owner
+	MappedFile(const MappedFile&) = delete;
+	void operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile &&other) noexcept;
+	MappedFile& operator=(MappedFile &&other) noexcept;
+
+	// Empty file opens fine, with data() == nullptr
+	// Example usecase:		MappedFile file; if (file.open(path)) { parse(file.data(), file.size()); }
+	bool open(const std::string &path);
+	void close();
+
+	bool isOpen() const { return m_open; }
+	const std::byte* data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	bool m_open = false;
+	const std::byte* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	// HANDLE, windows.h stays out of the header
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
+
+class AppendFile
+{
+public:
+	AppendFile() = default;
+	~AppendFile() { close(); }
+
+	AppendFile(const AppendFile&) = delete;
+	void operator=(const AppendFile&) = delete;
+
+	// Creates file if it doesn't exist, size() starts at its current size
+	bool open(const std::string &path);
+	void close();
+	bool append(const void* data, size_t bytes);
+	// Flushes our buffer and asks OS to write file to the disk
+	bool sync();
+
+	bool isOpen() const { return m_file != nullptr; }
+	size_t size() const { return m_size; }
+	const std::string& path() const { return m_path; }
+
+private:
+	std::FILE* m_file = nullptr;
+	size_t m_size = 0;
+	std::string m_path;
+};
+
+// Syncs the directory that holds path, so file created or renamed there is still there after power loss
+// Example usecase:		std::filesystem::rename(tmpPath, path); syncParentDirectory(path);
+bool syncParentDirectory(const std::string &path);
+
+// Standard CRC-32, crc of previous call can be passed in to continue it
+// Example usecase:		std::uint32_t crc = crc32(name.data(), name.size(), crc32(&header, sizeof(header)));
+std::uint32_t crc32(const void* data, size_t bytes, std::uint32_t crc = 0);
+
+#endif /* MAPPED_FILE_H */
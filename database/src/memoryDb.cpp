@@ -0,0 +1,173 @@
+#include "memoryDb.h"
+#include <algorithm>
+
+// InMemoryDatabase constructor
+// One table per banner, same as SQLDatabase
+InMemoryDatabase::InMemoryDatabase(bool indexed) : m_indexed(indexed)
+{
+}
+
+// Copy assignment reuses elements (and their strings) already in wishList
+void InMemoryDatabase::getWishes(Banner banner, std::vector<wishEntry> &wishList)
+{
+	auto &table = m_tables[static_cast<size_t>(banner)];
+	wishList.assign(table.rows.begin(), table.rows.end());
+}
+
+void InMemoryDatabase::insertWish(Banner banner, const wishEntry &wish)
+{
+	auto &table = m_tables[static_cast<size_t>(banner)];
+	size_t firstRow = table.rows.size();
+	append(table, wishEntry(wish));
+	sortByTime(table, firstRow);
+}
+
+void InMemoryDatabase::insertWishes(Banner banner, std::span<const wishEntry> wishes)
+{
+	auto &table = m_tables[static_cast<size_t>(banner)];
+	table.rows.reserve(table.rows.size() + wishes.size());
+	table.epochs.reserve(table.epochs.size() + wishes.size());
+	size_t firstRow = table.rows.size();
+	for (auto &wish : wishes)
+	{
+		append(table, wishEntry(wish));
+	}
+	sortByTime(table, firstRow);
+}
+
+// Rows are moved into the table, nothing is copied
+void InMemoryDatabase::insertWishes(Banner banner, std::vector<wishEntry> &&wishes)
+{
+	auto &table = m_tables[static_cast<size_t>(banner)];
+	table.rows.reserve(table.rows.size() + wishes.size());
+	table.epochs.reserve(table.epochs.size() + wishes.size());
+	size_t firstRow = table.rows.size();
+	for (auto &wish : wishes)
+	{
+		append(table, std::move(wish));
+	}
+	wishes.clear();
+	sortByTime(table, firstRow);
+}
+
+void InMemoryDatabase::forEachWish(Banner banner, const std::function<void(const wishEntry&)> &visit)
+{
+	for (auto &wish : m_tables[static_cast<size_t>(banner)].rows)
+	{
+		visit(wish);
+	}
+}
+
+size_t InMemoryDatabase::count(Banner banner) const
+{
+	return m_tables[static_cast<size_t>(banner)].rows.size();
+}
+
+// Uses item index if database is indexed, otherwise scans the table
+void InMemoryDatabase::getWishesByItem(Banner banner, const std::string &itemName, std::vector<wishEntry> &wishList)
+{
+	auto &table = m_tables[static_cast<size_t>(banner)];
+	wishList.clear();
+
+	if (m_indexed)
+	{
+		auto it = table.byItem.find(itemName);
+		if (it != table.byItem.end())
+		{
+			for (size_t row : it->second)
+			{
+				wishList.push_back(table.rows[row]);
+			}
+		}
+		return;
+	}
+
+	for (auto &wish : table.rows)
+	{
+		if (wish.itemName == itemName)
+		{
+			wishList.push_back(wish);
+		}
+	}
+}
+
+// Wishes received between from and to (epoch seconds, both inclusive), ordered by time
+// Uses time index if database is indexed, otherwise scans the table (and keeps insertion order)
+void InMemoryDatabase::getWishesInRange(Banner banner, long long from, long long to, std::vector<wishEntry> &wishList)
+{
+	auto &table = m_tables[static_cast<size_t>(banner)];
+	wishList.clear();
+
+	if (m_indexed)
+	{
+		auto epochOf = [&](size_t row) { return table.epochs[row]; };
+		auto first = std::lower_bound(table.byTime.begin(), table.byTime.end(), from,
+			[&](size_t row, long long value) { return epochOf(row) < value; });
+		auto last = std::upper_bound(first, table.byTime.end(), to,
+			[&](long long value, size_t row) { return value < epochOf(row); });
+		for (auto it = first; it != last; ++it)
+		{
+			wishList.push_back(table.rows[*it]);
+		}
+		return;
+	}
+
+	for (size_t row = 0; row < table.rows.size(); row++)
+	{
+		if (table.epochs[row] >= from && table.epochs[row] <= to)
+		{
+			wishList.push_back(table.rows[row]);
+		}
+	}
+}
+
+// Copies every table into db, one insertWishes (one transaction for SQLDatabase) per table
+void InMemoryDatabase::snapshotTo(Database &db) const
+{
+	for (Banner banner : g_banners)
+	{
+		auto &table = m_tables[static_cast<size_t>(banner)];
+		if (!table.rows.empty())
+		{
+			db.insertWishes(banner, std::span<const wishEntry>(table.rows));
+		}
+	}
+}
+
+void InMemoryDatabase::append(wishTable &table, wishEntry &&wish)
+{
+	size_t row = table.rows.size();
+	long long epoch = dateToEpoch(wish.date);
+
+	if (m_indexed)
+	{
+		table.byItem[wish.itemName].push_back(row);
+		// put in order by sortByTime once the whole batch is appended
+		table.byTime.push_back(row);
+	}
+
+	table.rows.push_back(std::move(wish));
+	table.epochs.push_back(epoch);
+}
+
+// Sorts rows appended since firstRow and merges them into time index, O(n + k log k) per batch instead of O(n) per row
+// Stable, rows with the same time stay in insertion order
+void InMemoryDatabase::sortByTime(wishTable &table, size_t firstRow)
+{
+	if (!m_indexed || firstRow == table.byTime.size())
+	{
+		return;
+	}
+
+	auto byEpoch = [&](size_t a, size_t b) { return table.epochs[a] < table.epochs[b]; };
+	auto middle = table.byTime.begin() + firstRow;
+	if (!std::is_sorted(middle, table.byTime.end(), byEpoch))
+	{
+		std::stable_sort(middle, table.byTime.end(), byEpoch);
+	}
+	// History is usually inserted in time order, then there is nothing to merge
+	if (middle != table.byTime.begin() && byEpoch(*middle, *(middle - 1)))
+	{
+		std::inplace_merge(table.byTime.begin(), middle, table.byTime.end(), byEpoch);
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef MEMORY_DATABASE_H
+#define MEMORY_DATABASE_H
+
+#include "db.h"
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+
+/*
+Database kept entirely in memory, for tests and analytics that shouldn't touch the disk.
+
+	each wish table is a contiguous vector of rows, in insertion order (same as SQLDatabase)
+	optional indexes: item name -> rows and rows sorted by time, maintained on insert (time index once per batch)
+	snapshotTo writes everything into another Database (e.g. SQLDatabase) in one insertWishes per table
+*/
+
+class InMemoryDatabase : public Database
+{
+public:
+	InMemoryDatabase(bool indexed = false);
+	~InMemoryDatabase() override {};
+
+	using Database::getWishes;
+	using Database::insertWishes;
+	void getWishes(Banner banner, std::vector<wishEntry> &wishList) override;
+	void insertWish(Banner banner, const wishEntry &wish) override;
+	void insertWishes(Banner banner, std::span<const wishEntry> wishes) override;
+	void insertWishes(Banner banner, std::vector<wishEntry> &&wishes) override;
+	void forEachWish(Banner banner, const std::function<void(const wishEntry&)> &visit) override;
+
+	size_t count(Banner banner) const;
+	void getWishesByItem(Banner banner, const std::string &itemName, std::vector<wishEntry> &wishList);
+	void getWishesInRange(Banner banner, long long from, long long to, std::vector<wishEntry> &wishList);
+	void snapshotTo(Database &db) const;
+
+private:
+	struct wishTable
+	{
+		std::vector<wishEntry> rows;
+		std::vector<long long> epochs;
+
+		// indexes, only filled if database is indexed
+		std::unordered_map<std::string, std::vector<size_t>> byItem;
+		std::vector<size_t> byTime;
+	};
+
+	void append(wishTable &table, wishEntry &&wish);
+	void sortByTime(wishTable &table, size_t firstRow);
+
+	const bool m_indexed;
+	std::array<wishTable, g_bannerCount> m_tables;
+};
+
+#endif /* MEMORY_DATABASE_H */
@@ -0,0 +1,170 @@
+#include "sqlFunctions.h"
+#include "db.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+	// epoch(date)
+	void epochFunction(sqlite3_context* context, int, sqlite3_value** argv)
+	{
+		const unsigned char* text = sqlite3_value_text(argv[0]);
+		long long epoch = text ? dateToEpoch(std::string_view(reinterpret_cast<const char*>(text), sqlite3_value_bytes(argv[0]))) : -1;
+		if (epoch < 0)
+		{
+			sqlite3_result_null(context);
+			return;
+		}
+		sqlite3_result_int64(context, epoch);
+	}
+
+	// Frame of pity() window, hits are wishes with rarity >= threshold
+	struct pityState
+	{
+		long long size;
+		long long hits;
+		long long pity;
+	};
+
+	bool isHit(int argc, sqlite3_value** argv)
+	{
+		int threshold = argc > 1 ? sqlite3_value_int(argv[1]) : 5;
+		return sqlite3_value_int(argv[0]) >= threshold;
+	}
+
+	// Row enters the frame (aggregate step)
+	void pityStep(sqlite3_context* context, int argc, sqlite3_value** argv)
+	{
+		if (sqlite3_value_type(argv[0]) == SQLITE_NULL)
+		{
+			return;
+		}
+		// zeroed by sqlite on first call
+		pityState* state = static_cast<pityState*>(sqlite3_aggregate_context(context, sizeof(pityState)));
+		if (!state)
+		{
+			sqlite3_result_error_nomem(context);
+			return;
+		}
+		state->size++;
+		if (isHit(argc, argv))
+		{
+			state->hits++;
+			state->pity = 0;
+		}
+		else
+		{
+			state->pity++;
+		}
+	}
+
+	// Oldest row leaves the frame, rows after the last hit stay the same unless there is no hit left
+	void pityInverse(sqlite3_context* context, int argc, sqlite3_value** argv)
+	{
+		if (sqlite3_value_type(argv[0]) == SQLITE_NULL)
+		{
+			return;
+		}
+		pityState* state = static_cast<pityState*>(sqlite3_aggregate_context(context, sizeof(pityState)));
+		if (!state)
+		{
+			sqlite3_result_error_nomem(context);
+			return;
+		}
+		state->size--;
+		if (isHit(argc, argv))
+		{
+			state->hits--;
+		}
+		if (state->hits == 0)
+		{
+			state->pity = state->size;
+		}
+	}
+
+	void pityValue(sqlite3_context* context)
+	{
+		// size 0 doesn't allocate, empty frame has no pity
+		pityState* state = static_cast<pityState*>(sqlite3_aggregate_context(context, 0));
+		sqlite3_result_int64(context, state ? state->pity : 0);
+	}
+
+	// Periods sorted by start, owned by sqlite (xDestroy) of every banner_of registration
+	using bannerSchedule = std::vector<bannerPeriod>;
+
+	void bannerOfFunction(sqlite3_context* context, int argc, sqlite3_value** argv)
+	{
+		const bannerSchedule &schedule = **static_cast<std::shared_ptr<const bannerSchedule>*>(sqlite3_user_data(context));
+		long long time;
+		switch (sqlite3_value_type(argv[0]))
+		{
+		case SQLITE_NULL:
+			sqlite3_result_null(context);
+			return;
+		case SQLITE_TEXT:
+			time = dateToEpoch(reinterpret_cast<const char*>(sqlite3_value_text(argv[0])));
+			break;
+		default:
+			time = sqlite3_value_int64(argv[0]);
+		}
+		int banner = argc > 1 ? sqlite3_value_int(argv[1]) : -1;
+
+		// Every period that started at or before time, newest first
+		auto it = std::upper_bound(schedule.begin(), schedule.end(), time,
+			[](long long value, const bannerPeriod &period) { return value < period.start; });
+		while (it != schedule.begin())
+		{
+			--it;
+			if (time < it->end && (banner < 0 || static_cast<int>(it->banner) == banner))
+			{
+				// schedule lives as long as this registration, so sqlite doesn't have to copy the name
+				sqlite3_result_text(context, it->name.c_str(), static_cast<int>(it->name.size()), SQLITE_STATIC);
+				return;
+			}
+		}
+		sqlite3_result_null(context);
+	}
+
+	void destroySchedule(void* schedule)
+	{
+		delete static_cast<std::shared_ptr<const bannerSchedule>*>(schedule);
+	}
+
+	bool check(sqlite3* handle, int rc, const char* function)
+	{
+		if (rc != SQLITE_OK)
+		{
+			std::cout << "error: can't register " << function << ": " << sqlite3_errmsg(handle) << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
+
+bool registerWishFunctions(sqlite3* handle)
+{
+	constexpr int pure = SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS;
+	bool ok = check(handle, sqlite3_create_function_v2(handle, "epoch", 1, pure, nullptr, epochFunction, nullptr, nullptr, nullptr), "epoch");
+	for (int argc = 1; argc <= 2; argc++)
+	{
+		ok &= check(handle, sqlite3_create_window_function(handle, "pity", argc, pure, nullptr,
+			pityStep, pityValue, pityValue, pityInverse, nullptr), "pity");
+	}
+	return setBannerSchedule(handle, {}) && ok;
+}
+
+bool setBannerSchedule(sqlite3* handle, std::vector<bannerPeriod> periods)
+{
+	std::stable_sort(periods.begin(), periods.end(), [](const bannerPeriod &a, const bannerPeriod &b) { return a.start < b.start; });
+	auto schedule = std::make_shared<const bannerSchedule>(std::move(periods));
+
+	bool ok = true;
+	for (int argc = 1; argc <= 2; argc++)
+	{
+		// sqlite calls destroySchedule for user data even if registration fails
+		ok &= check(handle, sqlite3_create_function_v2(handle, "banner_of", argc, SQLITE_UTF8 | SQLITE_DIRECTONLY,
+			new std::shared_ptr<const bannerSchedule>(schedule), bannerOfFunction, nullptr, nullptr, destroySchedule), "banner_of");
+	}
+	return ok;
+}
@@ -0,0 +1,38 @@
+#ifndef SQL_FUNCTIONS_H
+#define SQL_FUNCTIONS_H
+
+#include <sqlite3.h>
+#include "bannerSql.h"
+#include <string>
+#include <vector>
+
+/*
+Wish functions implemented in C++ and registered on sqlite connections, so analytic queries run inside sqlite.
+
+	epoch(date)				"YYYY-MM-DD HH:MM:SS" to epoch seconds (same conversion as dateToEpoch), NULL if it can't be parsed
+	pity(rarity[, threshold])		aggregate and window function, pulls since the last wish with rarity >= threshold (default 5),
+						0 right after such wish, same as pity4/pity5 of wishStats, NULL rarities are skipped
+						row order is the window order, so use it as window: pity(itemRarity) OVER (ORDER BY timeReceived, seq)
+						sliding frames (ROWS n PRECEDING) work too, frame keeps only count of hits
+	banner_of(time[, banner])		name of the event banner that ran at time (epoch seconds or date text), NULL outside of schedule
+						banner is the Banner value of the wish table, without it every period of the schedule matches
+	schedule is a list of [start, end) periods, they may overlap (two featured banners in one phase), latest started wins
+	banner_of is registered SQLITE_DIRECTONLY, schedule can change so it must not end up in schema (index, view, trigger)
+*/
+
+// Example usecase:		{ Banner::Character, dateToEpoch("2020-09-28 10:00:00"), dateToEpoch("2020-10-18 15:00:00"), "Ballad in Goblets" }
+struct bannerPeriod
+{
+	Banner banner;
+	long long start;
+	long long end;
+	std::string name;
+};
+
+// Registers every function, banner_of with empty schedule, returns false if sqlite rejected some of them
+// Example usecase:		registerWishFunctions(handle); sqlite3_prepare_v2(handle, "SELECT pity(itemRarity) OVER ...", ...);
+bool registerWishFunctions(sqlite3* handle);
+// Replaces schedule used by banner_of on this connection, it fails while some statement of the connection is running
+bool setBannerSchedule(sqlite3* handle, std::vector<bannerPeriod> periods);
+
+#endif /* SQL_FUNCTIONS_H */
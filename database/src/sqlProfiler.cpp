@@ -0,0 +1,237 @@
+#include "sqlProfiler.h"
+#include "logger/src/logger.h"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+SQLProfiler::SQLProfiler(std::chrono::microseconds slowThreshold) : m_slowThreshold(slowThreshold)
+{
+}
+
+// Connections still attached are detached, so sqlite never calls into destroyed profiler
+SQLProfiler::~SQLProfiler()
+{
+	std::vector<sqlite3*> handles;
+	{
+		std::lock_guard lock(m_mutex);
+		handles = m_handles;
+	}
+	for (auto handle : handles)
+	{
+		detach(handle);
+	}
+}
+
+// Example usecase:		profiler.attach(connection); ...; profiler.summary();
+void SQLProfiler::attach(sqlite3* handle)
+{
+	if (sqlite3_trace_v2(handle, SQLITE_TRACE_STMT | SQLITE_TRACE_ROW | SQLITE_TRACE_PROFILE, &SQLProfiler::traceCallback, this) != SQLITE_OK)
+	{
+		std::cout << "error: " << sqlite3_errmsg(handle);
+		return;
+	}
+	std::lock_guard lock(m_mutex);
+	m_handles.push_back(handle);
+}
+
+void SQLProfiler::detach(sqlite3* handle)
+{
+	sqlite3_trace_v2(handle, 0, nullptr, nullptr);
+	std::lock_guard lock(m_mutex);
+	m_handles.erase(std::remove(m_handles.begin(), m_handles.end(), handle), m_handles.end());
+}
+
+std::vector<SQLProfiler::statementStats> SQLProfiler::snapshot() const
+{
+	std::vector<statementStats> result;
+	{
+		std::lock_guard lock(m_mutex);
+		result.reserve(m_stats.size());
+		for (auto &entry : m_stats)
+		{
+			result.push_back(entry.second);
+		}
+	}
+	std::sort(result.begin(), result.end(), [](const statementStats &a, const statementStats &b) { return a.totalNs > b.totalNs; });
+	return result;
+}
+
+// One log line per statement, histogram lists only buckets that were hit
+// Example output:		12:55:44.792 [INFO] SQLProfiler: 1204x total 35.112ms max 0.413ms rows 1204 [<16us:1100 <32us:98 <512us:6] INSERT INTO ...
+void SQLProfiler::summary() const
+{
+	auto stats = snapshot();
+	Logger::getInstance().addLog("SQLProfiler", "summary of " + std::to_string(stats.size()) + " statements");
+	for (auto &statement : stats)
+	{
+		std::stringstream line;
+		line << statement.count << "x total " << std::fixed << std::setprecision(3) << statement.totalNs / 1e6 << "ms max "
+			<< statement.maxNs / 1e6 << "ms rows " << statement.rows << " [";
+		bool first = true;
+		for (size_t i = 0; i < bucketCount; i++)
+		{
+			if (statement.histogram[i] == 0)
+			{
+				continue;
+			}
+			line << (first ? "" : " ") << (i + 1 < bucketCount ? "<" : ">=") << (1ULL << (i + 1 < bucketCount ? i : i - 1))
+				<< "us:" << statement.histogram[i];
+			first = false;
+		}
+		line << "] " << statement.sql;
+		Logger::getInstance().addLog("SQLProfiler", line);
+	}
+}
+
+void SQLProfiler::reset()
+{
+	std::lock_guard lock(m_mutex);
+	m_stats.clear();
+	m_pending.clear();
+}
+
+// Literals are replaced by ?, whitespace runs by single space, so statements that differ only in values are grouped
+// Example usecase:		normalize("SELECT * FROM t WHERE id = 5 AND name = 'x'") == "SELECT * FROM t WHERE id = ? AND name = ?"
+std::string SQLProfiler::normalize(std::string_view sql)
+{
+	std::string result;
+	result.reserve(sql.size());
+	size_t i = 0;
+	while (i < sql.size())
+	{
+		char c = sql[i];
+		if (c == '\'')
+		{
+			// string literal, '' inside is an escaped quote
+			i++;
+			while (i < sql.size())
+			{
+				if (sql[i] == '\'' && (i + 1 >= sql.size() || sql[i + 1] != '\''))
+				{
+					break;
+				}
+				i += sql[i] == '\'' ? 2 : 1;
+			}
+			i++;
+			result += '?';
+		}
+		else if (std::isdigit(static_cast<unsigned char>(c)) &&
+			(result.empty() || !(std::isalnum(static_cast<unsigned char>(result.back())) || result.back() == '_')))
+		{
+			// number that isn't part of identifier (wishCharacter_v2, x1)
+			while (i < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '.'))
+			{
+				i++;
+			}
+			result += '?';
+		}
+		else if (std::isspace(static_cast<unsigned char>(c)))
+		{
+			while (i < sql.size() && std::isspace(static_cast<unsigned char>(sql[i])))
+			{
+				i++;
+			}
+			if (!result.empty())
+			{
+				result += ' ';
+			}
+		}
+		else
+		{
+			result += c;
+			i++;
+		}
+	}
+	while (!result.empty() && result.back() == ' ')
+	{
+		result.pop_back();
+	}
+	return result;
+}
+
+int SQLProfiler::traceCallback(unsigned int type, void* context, void* p, void* x)
+{
+	SQLProfiler* profiler = static_cast<SQLProfiler*>(context);
+	if (type == SQLITE_TRACE_STMT)
+	{
+		profiler->onStatement(static_cast<sqlite3_stmt*>(p));
+	}
+	else if (type == SQLITE_TRACE_ROW)
+	{
+		profiler->onRow(static_cast<sqlite3_stmt*>(p));
+	}
+	else if (type == SQLITE_TRACE_PROFILE)
+	{
+		profiler->onProfile(static_cast<sqlite3_stmt*>(p), static_cast<unsigned long long>(*static_cast<sqlite3_int64*>(x)));
+	}
+	return 0;
+}
+
+// Trigger programs report STMT again for the same stmt, the first start is kept
+void SQLProfiler::onStatement(sqlite3_stmt* stmt)
+{
+	sqlite3_int64 totalChanges = sqlite3_total_changes64(sqlite3_db_handle(stmt));
+	auto start = std::chrono::steady_clock::now();
+	std::lock_guard lock(m_mutex);
+	m_pending.try_emplace(stmt, pendingStatement{ start, totalChanges });
+}
+
+// Statement that started before attach is not pending, its rows are not counted
+void SQLProfiler::onRow(sqlite3_stmt* stmt)
+{
+	std::lock_guard lock(m_mutex);
+	auto pending = m_pending.find(stmt);
+	if (pending != m_pending.end())
+	{
+		pending->second.rows++;
+	}
+}
+
+// Called once statement finished (or was reset), sqliteNs is used only if we didn't see the statement start
+void SQLProfiler::onProfile(sqlite3_stmt* stmt, unsigned long long sqliteNs)
+{
+	auto end = std::chrono::steady_clock::now();
+	sqlite3* handle = sqlite3_db_handle(stmt);
+	// sqlite3_changes belongs to connection and keeps the count of the last INSERT/UPDATE/DELETE,
+	// so it's taken only if this statement moved the total (DDL and writes that changed nothing don't)
+	sqlite3_int64 totalChanges = sqlite3_total_changes64(handle);
+	unsigned long long changes = static_cast<unsigned long long>(sqlite3_changes64(handle));
+	const char* text = sqlite3_sql(stmt);
+	std::string sql = normalize(text ? text : "");
+
+	unsigned long long ns = sqliteNs;
+	{
+		std::lock_guard lock(m_mutex);
+		unsigned long long rows = 0;
+		auto pending = m_pending.find(stmt);
+		if (pending != m_pending.end())
+		{
+			ns = static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - pending->second.start).count());
+			rows = pending->second.rows + (totalChanges != pending->second.totalChanges ? changes : 0);
+			m_pending.erase(pending);
+		}
+		size_t bucket = std::min<size_t>(std::bit_width(ns / 1000), bucketCount - 1);
+
+		auto it = m_stats.find(sql);
+		if (it == m_stats.end())
+		{
+			it = m_stats.emplace(sql, statementStats{ sql }).first;
+		}
+		statementStats &stats = it->second;
+		stats.count++;
+		stats.totalNs += ns;
+		stats.maxNs = std::max(stats.maxNs, ns);
+		stats.rows += rows;
+		stats.histogram[bucket]++;
+	}
+
+	if (std::chrono::nanoseconds(ns) >= m_slowThreshold)
+	{
+		std::stringstream log;
+		log << "slow statement " << std::fixed << std::setprecision(3) << ns / 1e6 << "ms: " << sql;
+		Logger::getInstance().addLog("SQLProfiler", log, Logger::WARNING);
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef SQL_PROFILER_H
+#define SQL_PROFILER_H
+
+#include <sqlite3.h>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+Per-statement timing of sqlite connections, reported through Logger.
+
+	attach() registers sqlite3_trace_v2 on a connection, statement start is taken from steady_clock when sqlite
+	starts it and run time when it finishes (sqlite's own profile time has only millisecond resolution on Unix)
+	statements are grouped by normalized text: numbers and strings become ?, whitespace is collapsed,
+	so "... VALUES (0, 5)" and "... VALUES (1, 7)" count as one statement
+	every statement keeps count, total/max time, rows (returned for reads, changed for writes, DDL changes none)
+	and a log2 histogram of run times in microseconds
+	statements slower than slowThreshold are logged as WARNING right away, summary() logs the table sorted by total time
+	one profiler can be attached to many connections (SQLConnectionPool), callbacks take a mutex
+*/
+
+class SQLProfiler
+{
+public:
+	// bucket i counts statements that took less than 2^i microseconds, last bucket takes the rest
+	static constexpr size_t bucketCount = 24;
+
+	struct statementStats
+	{
+		std::string sql;
+		unsigned long long count = 0;
+		unsigned long long totalNs = 0;
+		unsigned long long maxNs = 0;
+		unsigned long long rows = 0;
+		std::array<unsigned long long, bucketCount> histogram{};
+	};
+
+	SQLProfiler(std::chrono::microseconds slowThreshold = std::chrono::milliseconds(100));
+	~SQLProfiler();
+
+	// disable copy and move, sqlite keeps pointer to us
+	SQLProfiler(const SQLProfiler&) = delete;
+	void operator=(const SQLProfiler&) = delete;
+	SQLProfiler(SQLProfiler&&) = delete;
+	void operator=(SQLProfiler&&) = delete;
+
+	void attach(sqlite3* handle);
+	void detach(sqlite3* handle);
+	// sorted by total time, slowest first
+	std::vector<statementStats> snapshot() const;
+	void summary() const;
+	void reset();
+
+	static std::string normalize(std::string_view sql);
+
+private:
+	static int traceCallback(unsigned int type, void* context, void* p, void* x);
+	void onStatement(sqlite3_stmt* stmt);
+	void onRow(sqlite3_stmt* stmt);
+	void onProfile(sqlite3_stmt* stmt, unsigned long long ns);
+
+	// statement that is still running
+	struct pendingStatement
+	{
+		std::chrono::steady_clock::time_point start;
+		// sqlite3_total_changes64 of the connection when statement started
+		sqlite3_int64 totalChanges = 0;
+		unsigned long long rows = 0;
+	};
+
+	const std::chrono::microseconds m_slowThreshold;
+	mutable std::mutex m_mutex;
+	std::unordered_map<std::string, statementStats> m_stats;
+	std::unordered_map<sqlite3_stmt*, pendingStatement> m_pending;
+	std::vector<sqlite3*> m_handles;
+};
+
+#endif /* SQL_PROFILER_H */
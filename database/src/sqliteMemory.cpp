@@ -0,0 +1,111 @@
+#include "sqliteMemory.h"
+#include "logger/src/logger.h"
+#include <climits>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+// Memory handed to sqlite, it must outlive every use, so it's only replaced while sqlite is shut down
+// uint64_t elements keep both buffers 8-byte aligned, as sqlite requires
+static std::unique_ptr<std::uint64_t[]> g_heapBuffer;
+static std::unique_ptr<std::uint64_t[]> g_pageCacheBuffer;
+
+bool configureSqliteMemory(const sqliteMemoryConfig &config)
+{
+	if (sqlite3_shutdown() != SQLITE_OK)
+	{
+		std::cout << "error: sqlite can't be shut down to change memory configuration\n";
+		return false;
+	}
+
+	bool ok = true;
+	if (sqlite3_config(SQLITE_CONFIG_MEMSTATUS, config.statistics ? 1 : 0) != SQLITE_OK)
+	{
+		std::cout << "error: SQLITE_CONFIG_MEMSTATUS rejected\n";
+		ok = false;
+	}
+
+	// sqlite takes sizes as int, bigger buffer would be truncated to some other size
+	size_t heapWords = (config.heapBytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+	if (heapWords > INT_MAX / sizeof(std::uint64_t))
+	{
+		std::cout << "error: heap of " << config.heapBytes << " B is bigger than sqlite can take (" << INT_MAX << " B), using malloc\n";
+		heapWords = 0;
+		ok = false;
+	}
+	g_heapBuffer.reset();
+	if (heapWords > 0)
+	{
+		g_heapBuffer = std::make_unique<std::uint64_t[]>(heapWords);
+		if (sqlite3_config(SQLITE_CONFIG_HEAP, g_heapBuffer.get(), static_cast<int>(heapWords * sizeof(std::uint64_t)), config.heapMinAllocation) != SQLITE_OK)
+		{
+			std::cout << "error: SQLITE_CONFIG_HEAP rejected, sqlite has to be built with SQLITE_ENABLE_MEMSYS5\n";
+			g_heapBuffer.reset();
+			ok = false;
+		}
+	}
+	else
+	{
+		// null heap switches back to malloc
+		sqlite3_config(SQLITE_CONFIG_HEAP, nullptr, 0, 0);
+	}
+
+	int headerSize = 0;
+	sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &headerSize);
+	// slot size has to be multiple of 8
+	size_t slotSize = config.pageSize > 0 ? (static_cast<size_t>(config.pageSize) + headerSize + 7) & ~static_cast<size_t>(7) : 0;
+	size_t pageCacheWords = config.pageCacheSlots > 0 ? slotSize * config.pageCacheSlots / sizeof(std::uint64_t) : 0;
+	if (config.pageCacheSlots > 0 && (slotSize == 0 || pageCacheWords > INT_MAX / sizeof(std::uint64_t)))
+	{
+		std::cout << "error: page cache of " << config.pageCacheSlots << " slots of " << config.pageSize
+			<< " B pages doesn't fit in " << INT_MAX << " B, using default page cache\n";
+		pageCacheWords = 0;
+		ok = false;
+	}
+	g_pageCacheBuffer.reset();
+	if (pageCacheWords > 0)
+	{
+		g_pageCacheBuffer = std::make_unique<std::uint64_t[]>(pageCacheWords);
+		if (sqlite3_config(SQLITE_CONFIG_PAGECACHE, g_pageCacheBuffer.get(), static_cast<int>(slotSize), config.pageCacheSlots) != SQLITE_OK)
+		{
+			std::cout << "error: SQLITE_CONFIG_PAGECACHE rejected\n";
+			g_pageCacheBuffer.reset();
+			ok = false;
+		}
+	}
+	else
+	{
+		sqlite3_config(SQLITE_CONFIG_PAGECACHE, nullptr, 0, 0);
+	}
+
+	if (sqlite3_initialize() != SQLITE_OK)
+	{
+		std::cout << "error: sqlite failed to initialize\n";
+		return false;
+	}
+	return ok;
+}
+
+// Counters are zero unless statistics are on (sqliteMemoryConfig::statistics)
+sqliteMemoryStats getSqliteMemoryStats(bool resetPeaks)
+{
+	sqliteMemoryStats stats;
+	sqlite3_int64 unused;
+	sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &stats.memoryUsed, &stats.memoryUsedPeak, resetPeaks);
+	sqlite3_status64(SQLITE_STATUS_MALLOC_SIZE, &unused, &stats.largestAllocation, resetPeaks);
+	sqlite3_status64(SQLITE_STATUS_PAGECACHE_USED, &stats.pageCacheSlotsUsed, &stats.pageCacheSlotsUsedPeak, resetPeaks);
+	sqlite3_status64(SQLITE_STATUS_PAGECACHE_OVERFLOW, &stats.pageCacheOverflowBytes, &stats.pageCacheOverflowBytesPeak, resetPeaks);
+	return stats;
+}
+
+void logSqliteMemoryStats()
+{
+	sqliteMemoryStats stats = getSqliteMemoryStats();
+	std::stringstream log;
+	log << std::fixed << std::setprecision(1) << "memory " << stats.memoryUsed / 1048576.0 << "/" << stats.memoryUsedPeak / 1048576.0
+		<< " MiB (current/peak), largest allocation " << stats.largestAllocation << " B, page cache " << stats.pageCacheSlotsUsed
+		<< "/" << stats.pageCacheSlotsUsedPeak << " slots, overflow " << stats.pageCacheOverflowBytes / 1024.0 << "/"
+		<< stats.pageCacheOverflowBytesPeak / 1024.0 << " KiB";
+	Logger::getInstance().addLog("sqlite", log);
+}
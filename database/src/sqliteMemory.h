@@ -0,0 +1,53 @@
+#ifndef SQLITE_MEMORY_H
+#define SQLITE_MEMORY_H
+
+#include <sqlite3.h>
+#include <cstddef>
+
+/*
+Process wide memory setup of sqlite.
+
+	by default sqlite takes every allocation (pages of cache included) from malloc, big imports leave the heap fragmented
+	heap: one preallocated block handed to sqlite's buddy allocator (SQLITE_CONFIG_HEAP, needs SQLITE_ENABLE_MEMSYS5),
+	every sqlite allocation comes from it, so sqlite can never use more memory than that
+	page cache: fixed number of page sized slots (SQLITE_CONFIG_PAGECACHE), cache pages don't go through the allocator at all,
+	pages that don't fit into slots overflow to heap/malloc (see pageCacheOverflowBytes)
+	sqlite reads this configuration only while it's not initialized, configureSqliteMemory shuts it down first,
+	so it has to be called while no connection is open - at startup, before first SQLDatabase
+*/
+
+struct sqliteMemoryConfig
+{
+	// 0 keeps malloc
+	size_t heapBytes = 0;
+	// smallest allocation of the heap, rounded up to power of two
+	int heapMinAllocation = 64;
+	// 0 keeps default page cache
+	int pageCacheSlots = 0;
+	// has to match PRAGMA page_size of the db, slot is page plus sqlite's header
+	int pageSize = 4096;
+	// turns on sqlite3_status counters, our sqlite build has them off (SQLITE_DEFAULT_MEMSTATUS=0)
+	bool statistics = true;
+};
+
+struct sqliteMemoryStats
+{
+	long long memoryUsed = 0;
+	long long memoryUsedPeak = 0;
+	long long largestAllocation = 0;
+	long long pageCacheSlotsUsed = 0;
+	long long pageCacheSlotsUsedPeak = 0;
+	long long pageCacheOverflowBytes = 0;
+	long long pageCacheOverflowBytesPeak = 0;
+};
+
+// Returns false if sqlite refused some part of config, parts it accepted stay in effect
+// heap and page cache have to fit in INT_MAX bytes (sqlite takes int sizes), bigger ones are refused
+// Example usecase:		configureSqliteMemory({ .heapBytes = 32 << 20, .pageCacheSlots = 2000 });
+bool configureSqliteMemory(const sqliteMemoryConfig &config);
+// resetPeaks starts new peak measurement after reading
+sqliteMemoryStats getSqliteMemoryStats(bool resetPeaks = false);
+// Example output:		12:55:44.792 [INFO] sqlite: memory 1.2/3.4 MiB (current/peak), largest allocation 65536 B, page cache 120/300 slots, overflow 0/0 KiB
+void logSqliteMemoryStats();
+
+#endif /* SQLITE_MEMORY_H */
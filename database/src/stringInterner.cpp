@@ -0,0 +1,56 @@
+#include "stringInterner.h"
+#include <mutex>
+
+// Get process wide interner (Singleton), used for item names
+StringInterner& StringInterner::getInstance()
+{
+	static StringInterner instance;
+	return instance;
+}
+
+// Returns id of str, adding it if it wasn't interned yet
+// Example usecase:		auto id = StringInterner::getInstance().intern("Ganyu");
+std::uint32_t StringInterner::intern(std::string_view str)
+{
+	{
+		std::shared_lock lock(m_mutex);
+		auto it = m_ids.find(str);
+		if (it != m_ids.end())
+		{
+			return it->second;
+		}
+	}
+
+	std::unique_lock lock(m_mutex);
+	// someone could intern it between the locks
+	auto it = m_ids.find(str);
+	if (it != m_ids.end())
+	{
+		return it->second;
+	}
+
+	std::uint32_t id = static_cast<std::uint32_t>(m_strings.size());
+	m_strings.emplace_back(str);
+	m_ids.emplace(m_strings.back(), id);
+	return id;
+}
+
+// Returns id of str or npos, never adds anything
+std::uint32_t StringInterner::find(std::string_view str) const
+{
+	std::shared_lock lock(m_mutex);
+	auto it = m_ids.find(str);
+	return it == m_ids.end() ? npos : it->second;
+}
+
+const std::string& StringInterner::name(std::uint32_t id) const
+{
+	std::shared_lock lock(m_mutex);
+	return m_strings[id];
+}
+
+size_t StringInterner::size() const
+{
+	std::shared_lock lock(m_mutex);
+	return m_strings.size();
+}
@@ -0,0 +1,46 @@
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <shared_mutex>
+
+/*
+Maps strings (item names) to dense 32-bit ids and back.
+
+	there are only a few hundred item names, so wishes can carry an id instead of a std::string
+	ids are process wide (getInstance), so they mean the same thing in every Database backend
+	strings are stored once in a deque, references returned by name() stay valid forever
+	lookups take a shared lock, only interning a new string takes the exclusive one
+*/
+
+class StringInterner
+{
+public:
+	static constexpr std::uint32_t npos = 0xFFFFFFFF;
+
+	// disable copy and move
+	StringInterner() = default;
+	StringInterner(const StringInterner&) = delete;
+	void operator=(const StringInterner&) = delete;
+	StringInterner(StringInterner&&) = delete;
+	void operator=(StringInterner&&) = delete;
+
+	static StringInterner& getInstance();
+
+	std::uint32_t intern(std::string_view str);
+	std::uint32_t find(std::string_view str) const;
+	const std::string& name(std::uint32_t id) const;
+	size_t size() const;
+
+private:
+	std::deque<std::string> m_strings;
+	// keys point into m_strings, so lookup by string_view doesn't allocate
+	std::unordered_map<std::string_view, std::uint32_t> m_ids;
+	mutable std::shared_mutex m_mutex;
+};
+
+#endif /* STRING_INTERNER_H */
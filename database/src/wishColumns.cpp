@@ -0,0 +1,128 @@
+#include "wishColumns.h"
+
+// Goes through compact getWishes, so no strings are created for backends that store item ids
+void WishColumns::load(Database &db, Banner banner)
+{
+	std::vector<compactWish> wishes;
+	db.getWishes(banner, wishes);
+	load(wishes);
+}
+
+void WishColumns::load(const std::vector<wishEntry> &wishes)
+{
+	clear();
+	reserve(wishes.size());
+	for (auto &wish : wishes)
+	{
+		append(wish);
+	}
+}
+
+void WishColumns::load(const std::vector<compactWish> &wishes)
+{
+	clear();
+	reserve(wishes.size());
+	for (auto &wish : wishes)
+	{
+		append(wish);
+	}
+}
+
+void WishColumns::append(const wishEntry &wish)
+{
+	append(toCompactWish(wish));
+}
+
+void WishColumns::append(const compactWish &wish)
+{
+	if (!m_time.empty() && wish.time < m_time.back())
+	{
+		m_timeOrdered = false;
+	}
+	m_time.push_back(wish.time);
+	m_rarity.push_back(wish.itemRarity);
+	m_itemId.push_back(wish.itemId);
+	m_type.push_back(static_cast<std::uint8_t>(wish.itemType));
+}
+
+void WishColumns::reserve(size_t count)
+{
+	m_time.reserve(count);
+	m_rarity.reserve(count);
+	m_itemId.reserve(count);
+	m_type.reserve(count);
+}
+
+void WishColumns::clear()
+{
+	m_time.clear();
+	m_rarity.clear();
+	m_itemId.clear();
+	m_type.clear();
+	m_timeOrdered = true;
+}
+
+wishEntry WishColumns::row(size_t index) const
+{
+	return toWishEntry(compactWish{ m_time[index], m_itemId[index], static_cast<wishItemType>(m_type[index]), m_rarity[index] });
+}
+
+std::array<size_t, 6> WishColumns::countByRarity() const
+{
+	std::array<size_t, 6> counts{};
+	for (std::uint8_t rarity : m_rarity)
+	{
+		if (rarity < counts.size())
+			counts[rarity]++;
+	}
+	return counts;
+}
+
+size_t WishColumns::currentPity(std::uint8_t rarity) const
+{
+	size_t pulls = 0;
+	for (size_t i = m_rarity.size(); i > 0; i--)
+	{
+		if (m_rarity[i - 1] >= rarity)
+			break;
+		pulls++;
+	}
+	return pulls;
+}
+
+std::vector<unsigned int> WishColumns::pityHistory(std::uint8_t rarity) const
+{
+	std::vector<unsigned int> history;
+	unsigned int pulls = 0;
+	for (std::uint8_t r : m_rarity)
+	{
+		pulls++;
+		if (r >= rarity)
+		{
+			history.push_back(pulls);
+			pulls = 0;
+		}
+	}
+	return history;
+}
+
+// Example usecase:		countPerBucket(dateToEpoch("2021-01-01 00:00:00"), 86400, 31, 4) - 4 and 5 star wishes per day in January
+std::vector<size_t> WishColumns::countPerBucket(long long origin, long long bucketSeconds, size_t bucketCount, std::uint8_t minRarity) const
+{
+	std::vector<size_t> buckets(bucketCount, 0);
+	if (bucketSeconds <= 0)
+	{
+		return buckets;
+	}
+
+	long long end = origin + bucketSeconds * static_cast<long long>(bucketCount);
+	for (size_t i = 0; i < m_time.size(); i++)
+	{
+		long long time = m_time[i];
+		if (time >= origin && time < end && m_rarity[i] >= minRarity)
+		{
+			buckets[static_cast<size_t>((time - origin) / bucketSeconds)]++;
+		}
+	}
+	return buckets;
+}
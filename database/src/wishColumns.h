@@ -0,0 +1,57 @@
+#ifndef WISH_COLUMNS_H
+#define WISH_COLUMNS_H
+
+#include "db.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Banner history stored column by column (structure of arrays).
+
+	one contiguous array per field: epoch time, rarity, item id, item type
+	item ids come from StringInterner, so rows only hold the id and columns can be compared across banners
+	aggregations below are plain loops over one or two arrays, compilers vectorize them
+	rows are kept in load order, for pity this has to be the order wishes were made (table order)
+	timeOrdered() tells if times never decrease, range lookups can then binary search times (see wishColumnsTable.h)
+*/
+
+class WishColumns
+{
+public:
+	void load(Database &db, Banner banner);
+	void load(const std::vector<wishEntry> &wishes);
+	void load(const std::vector<compactWish> &wishes);
+	void append(const wishEntry &wish);
+	void append(const compactWish &wish);
+	void reserve(size_t count);
+	void clear();
+
+	size_t size() const { return m_time.size(); }
+	bool timeOrdered() const { return m_timeOrdered; }
+	const std::vector<long long>& times() const { return m_time; }
+	const std::vector<std::uint8_t>& rarities() const { return m_rarity; }
+	const std::vector<std::uint32_t>& itemIds() const { return m_itemId; }
+	const std::vector<std::uint8_t>& types() const { return m_type; }
+	const std::string& itemName(std::uint32_t itemId) const { return StringInterner::getInstance().name(itemId); }
+	wishEntry row(size_t index) const;
+
+	// index is rarity, 0-5
+	std::array<size_t, 6> countByRarity() const;
+	// pulls made since last wish of at least given rarity
+	size_t currentPity(std::uint8_t rarity) const;
+	// for every wish of at least given rarity, number of pulls it took to get it
+	std::vector<unsigned int> pityHistory(std::uint8_t rarity) const;
+	// wishes of at least minRarity per time bucket, bucket i covers [origin + i * bucketSeconds, origin + (i + 1) * bucketSeconds)
+	std::vector<size_t> countPerBucket(long long origin, long long bucketSeconds, size_t bucketCount, std::uint8_t minRarity = 0) const;
+
+private:
+	std::vector<long long> m_time;
+	std::vector<std::uint8_t> m_rarity;
+	std::vector<std::uint32_t> m_itemId;
+	std::vector<std::uint8_t> m_type;
+	bool m_timeOrdered = true;
+};
+
+#endif /* WISH_COLUMNS_H */
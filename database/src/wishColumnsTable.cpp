@@ -0,0 +1,329 @@
+#include "wishColumnsTable.h"
+#include "wishColumns.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	enum column
+	{
+		Time = 0,
+		Rarity = 1,
+		ItemId = 2,
+		ItemType = 3,
+		ItemName = 4
+	};
+
+	struct columnsTable
+	{
+		sqlite3_vtab base;
+		const WishColumns* columns;
+	};
+
+	// Visits rows [row, end) that are inside both ranges
+	struct columnsCursor
+	{
+		sqlite3_vtab_cursor base;
+		size_t row;
+		size_t end;
+		long long timeLow;
+		long long timeHigh;
+		long long rarityLow;
+		long long rarityHigh;
+	};
+
+	const WishColumns& columnsOf(sqlite3_vtab_cursor* cursor)
+	{
+		return *reinterpret_cast<columnsTable*>(cursor->pVtab)->columns;
+	}
+
+	int connect(sqlite3* db, void* aux, int, const char* const*, sqlite3_vtab** vtab, char**)
+	{
+		int rc = sqlite3_declare_vtab(db, "CREATE TABLE x(time integer, rarity integer, itemId integer, itemType text, itemName text);");
+		if (rc != SQLITE_OK)
+		{
+			return rc;
+		}
+		sqlite3_vtab_config(db, SQLITE_VTAB_INNOCUOUS);
+
+		columnsTable* table = new columnsTable{};
+		table->columns = static_cast<const WishColumns*>(aux);
+		*vtab = &table->base;
+		return SQLITE_OK;
+	}
+
+	int disconnect(sqlite3_vtab* vtab)
+	{
+		delete reinterpret_cast<columnsTable*>(vtab);
+		return SQLITE_OK;
+	}
+
+	// Constraint op as one character of idxStr
+	char opCode(unsigned char op)
+	{
+		switch (op)
+		{
+		case SQLITE_INDEX_CONSTRAINT_EQ: return '=';
+		case SQLITE_INDEX_CONSTRAINT_GT: return '>';
+		case SQLITE_INDEX_CONSTRAINT_GE: return 'g';
+		case SQLITE_INDEX_CONSTRAINT_LT: return '<';
+		case SQLITE_INDEX_CONSTRAINT_LE: return 'l';
+		default: return 0;
+		}
+	}
+
+	// Plan is idxStr, two characters per filter argument: column (t or r) and op (opCode)
+	int bestIndex(sqlite3_vtab* vtab, sqlite3_index_info* info)
+	{
+		const WishColumns &columns = *reinterpret_cast<columnsTable*>(vtab)->columns;
+		std::string plan;
+		bool timeLimited = false;
+		bool rarityLimited = false;
+		for (int i = 0; i < info->nConstraint; i++)
+		{
+			auto &constraint = info->aConstraint[i];
+			char op = opCode(constraint.op);
+			if (!constraint.usable || !op || (constraint.iColumn != Time && constraint.iColumn != Rarity))
+			{
+				continue;
+			}
+			plan += constraint.iColumn == Time ? 't' : 'r';
+			plan += op;
+			info->aConstraintUsage[i].argvIndex = static_cast<int>(plan.size() / 2);
+			info->aConstraintUsage[i].omit = 1;
+			(constraint.iColumn == Time ? timeLimited : rarityLimited) = true;
+		}
+
+		double rows = static_cast<double>(std::max<size_t>(columns.size(), 1));
+		double estimate = rows * (timeLimited ? 0.25 : 1.0) * (rarityLimited ? 0.25 : 1.0);
+		// binary search finds the range, otherwise every row is checked
+		info->estimatedCost = timeLimited && columns.timeOrdered() ? std::log2(rows) + rows * 0.25 : rows;
+		info->estimatedRows = static_cast<sqlite3_int64>(std::max(estimate, 1.0));
+
+		// rows come out in rowid order, which is time order if times are ordered
+		if (info->nOrderBy == 1 && !info->aOrderBy[0].desc &&
+			(info->aOrderBy[0].iColumn == -1 || (info->aOrderBy[0].iColumn == Time && columns.timeOrdered())))
+		{
+			info->orderByConsumed = 1;
+		}
+
+		if (!plan.empty())
+		{
+			info->idxStr = sqlite3_mprintf("%s", plan.c_str());
+			info->needToFreeIdxStr = 1;
+		}
+		return SQLITE_OK;
+	}
+
+	// Narrows [low, high] to integers that satisfy "integer op value", with sqlite's comparison rules
+	// Returns false if no integer does
+	bool narrow(char op, sqlite3_value* value, long long &low, long long &high)
+	{
+		// numeric text is compared as number (integer column affinity)
+		int type = sqlite3_value_numeric_type(value);
+		if (type == SQLITE_NULL)
+		{
+			return false;
+		}
+		if (type == SQLITE_TEXT || type == SQLITE_BLOB)
+		{
+			// integers sort before text and blobs
+			return op == '<' || op == 'l';
+		}
+
+		long long floor;
+		long long ceil;
+		if (type == SQLITE_INTEGER)
+		{
+			floor = ceil = sqlite3_value_int64(value);
+		}
+		else
+		{
+			// far outside of any time or rarity, so clamping doesn't change result
+			double number = std::clamp(sqlite3_value_double(value), -1e18, 1e18);
+			floor = static_cast<long long>(std::floor(number));
+			ceil = static_cast<long long>(std::ceil(number));
+		}
+
+		switch (op)
+		{
+		case '=':
+			if (floor != ceil)
+				return false;
+			low = std::max(low, floor);
+			high = std::min(high, floor);
+			break;
+		case '>':
+			if (floor == LLONG_MAX)
+				return false;
+			low = std::max(low, floor + 1);
+			break;
+		case 'g':
+			low = std::max(low, ceil);
+			break;
+		case '<':
+			if (ceil == LLONG_MIN)
+				return false;
+			high = std::min(high, ceil - 1);
+			break;
+		case 'l':
+			high = std::min(high, floor);
+			break;
+		}
+		return low <= high;
+	}
+
+	bool matches(const WishColumns &columns, const columnsCursor &cursor, size_t row)
+	{
+		long long time = columns.times()[row];
+		long long rarity = columns.rarities()[row];
+		return time >= cursor.timeLow && time <= cursor.timeHigh && rarity >= cursor.rarityLow && rarity <= cursor.rarityHigh;
+	}
+
+	void skipToMatch(const WishColumns &columns, columnsCursor &cursor)
+	{
+		while (cursor.row < cursor.end && !matches(columns, cursor, cursor.row))
+		{
+			cursor.row++;
+		}
+	}
+
+	int open(sqlite3_vtab*, sqlite3_vtab_cursor** cursor)
+	{
+		columnsCursor* created = new columnsCursor{};
+		*cursor = &created->base;
+		return SQLITE_OK;
+	}
+
+	int close(sqlite3_vtab_cursor* cursor)
+	{
+		delete reinterpret_cast<columnsCursor*>(cursor);
+		return SQLITE_OK;
+	}
+
+	int filter(sqlite3_vtab_cursor* base, int, const char* idxStr, int argc, sqlite3_value** argv)
+	{
+		columnsCursor &cursor = *reinterpret_cast<columnsCursor*>(base);
+		const WishColumns &columns = columnsOf(base);
+		cursor.timeLow = cursor.rarityLow = LLONG_MIN;
+		cursor.timeHigh = cursor.rarityHigh = LLONG_MAX;
+		cursor.row = 0;
+		cursor.end = columns.size();
+
+		bool possible = true;
+		for (int i = 0; i < argc && possible; i++)
+		{
+			bool time = idxStr[2 * i] == 't';
+			possible = narrow(idxStr[2 * i + 1], argv[i], time ? cursor.timeLow : cursor.rarityLow, time ? cursor.timeHigh : cursor.rarityHigh);
+		}
+		if (!possible)
+		{
+			cursor.end = 0;
+			return SQLITE_OK;
+		}
+
+		if (columns.timeOrdered() && (cursor.timeLow != LLONG_MIN || cursor.timeHigh != LLONG_MAX))
+		{
+			auto &times = columns.times();
+			cursor.row = std::lower_bound(times.begin(), times.end(), cursor.timeLow) - times.begin();
+			cursor.end = std::upper_bound(times.begin() + cursor.row, times.end(), cursor.timeHigh) - times.begin();
+		}
+		skipToMatch(columns, cursor);
+		return SQLITE_OK;
+	}
+
+	int next(sqlite3_vtab_cursor* base)
+	{
+		columnsCursor &cursor = *reinterpret_cast<columnsCursor*>(base);
+		cursor.row++;
+		skipToMatch(columnsOf(base), cursor);
+		return SQLITE_OK;
+	}
+
+	int eof(sqlite3_vtab_cursor* base)
+	{
+		columnsCursor &cursor = *reinterpret_cast<columnsCursor*>(base);
+		return cursor.row >= cursor.end;
+	}
+
+	int columnValue(sqlite3_vtab_cursor* base, sqlite3_context* context, int index)
+	{
+		const WishColumns &columns = columnsOf(base);
+		size_t row = reinterpret_cast<columnsCursor*>(base)->row;
+		switch (index)
+		{
+		case Time:
+			sqlite3_result_int64(context, columns.times()[row]);
+			break;
+		case Rarity:
+			sqlite3_result_int(context, columns.rarities()[row]);
+			break;
+		case ItemId:
+			sqlite3_result_int64(context, columns.itemIds()[row]);
+			break;
+		case ItemType:
+			sqlite3_result_text(context, itemTypeToString(static_cast<wishItemType>(columns.types()[row])), -1, SQLITE_STATIC);
+			break;
+		case ItemName:
+		{
+			// interned strings are never moved or freed
+			const std::string &name = columns.itemName(columns.itemIds()[row]);
+			sqlite3_result_text(context, name.c_str(), static_cast<int>(name.size()), SQLITE_STATIC);
+			break;
+		}
+		}
+		return SQLITE_OK;
+	}
+
+	int rowid(sqlite3_vtab_cursor* base, sqlite3_int64* rowid)
+	{
+		*rowid = static_cast<sqlite3_int64>(reinterpret_cast<columnsCursor*>(base)->row);
+		return SQLITE_OK;
+	}
+
+	// No xCreate, so the table is eponymous only, read only (no xUpdate)
+	const sqlite3_module g_columnsModule = {
+		.iVersion = 0,
+		.xCreate = nullptr,
+		.xConnect = connect,
+		.xBestIndex = bestIndex,
+		.xDisconnect = disconnect,
+		.xDestroy = disconnect,
+		.xOpen = open,
+		.xClose = close,
+		.xFilter = filter,
+		.xNext = next,
+		.xEof = eof,
+		.xColumn = columnValue,
+		.xRowid = rowid,
+		.xUpdate = nullptr,
+		.xBegin = nullptr,
+		.xSync = nullptr,
+		.xCommit = nullptr,
+		.xRollback = nullptr,
+		.xFindFunction = nullptr,
+		.xRename = nullptr,
+		.xSavepoint = nullptr,
+		.xRelease = nullptr,
+		.xRollbackTo = nullptr,
+		.xShadowName = nullptr
+	};
+}
+
+bool registerColumnsTable(sqlite3* handle, const std::string &name, const WishColumns &columns)
+{
+	if (sqlite3_create_module_v2(handle, name.c_str(), &g_columnsModule, const_cast<WishColumns*>(&columns), nullptr) != SQLITE_OK)
+	{
+		std::cout << "error: can't register table " << name << ": " << sqlite3_errmsg(handle) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Module without implementation removes the name
+bool unregisterColumnsTable(sqlite3* handle, const std::string &name)
+{
+	return sqlite3_create_module_v2(handle, name.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+}
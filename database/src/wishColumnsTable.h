@@ -0,0 +1,26 @@
+#ifndef WISH_COLUMNS_TABLE_H
+#define WISH_COLUMNS_TABLE_H
+
+#include <sqlite3.h>
+#include <string>
+
+class WishColumns;
+
+/*
+WishColumns exposed to sqlite as a read-only virtual table, so ad-hoc SQL runs over wishes that aren't committed yet.
+
+	each registration is its own eponymous module, table exists as soon as it's registered, no CREATE VIRTUAL TABLE:
+	SELECT rarity, count(*) FROM pending WHERE time >= epoch('2021-01-01 00:00:00') GROUP BY rarity
+	columns: time integer, rarity integer, itemId integer, itemType text, itemName text, rowid is position in WishColumns
+	constraints on time and rarity (=, <, <=, >, >=) are handled by the table, sqlite doesn't check them again,
+	when times are ordered (WishColumns::timeOrdered) time range is found by binary search instead of a scan
+	ORDER BY rowid (and time, if ordered) comes for free
+	rows are read straight from the column arrays, itemName is looked up only if query asks for it
+	table keeps a reference, WishColumns has to outlive the registration and must not change while a statement reads it
+*/
+
+// Example usecase:		registerColumnsTable(handle, "pending", columns); ... unregisterColumnsTable(handle, "pending");
+bool registerColumnsTable(sqlite3* handle, const std::string &name, const WishColumns &columns);
+bool unregisterColumnsTable(sqlite3* handle, const std::string &name);
+
+#endif /* WISH_COLUMNS_TABLE_H */
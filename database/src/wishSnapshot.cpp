@@ -0,0 +1,368 @@
+#include "wishSnapshot.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+static_assert(sizeof(WishSnapshot::fileHeader) == 40, "fileHeader is part of the file format");
+static_assert(sizeof(WishSnapshot::bannerEntry) == 64, "bannerEntry is part of the file format");
+static_assert(sizeof(WishSnapshot::timeBlock) == 16, "timeBlock is part of the file format");
+
+constexpr char g_snapshotMagic[4] = { 'G', 'W', 'V', 'C' };
+constexpr std::uint32_t g_snapshotVersion = 1;
+constexpr std::uint64_t g_sectionAlignment = 8;
+
+static std::uint64_t alignSection(std::uint64_t offset)
+{
+	return (offset + g_sectionAlignment - 1) / g_sectionAlignment * g_sectionAlignment;
+}
+
+// Section of bytes at offset is inside the file and aligned for its type
+static bool sectionFits(std::uint64_t offset, std::uint64_t count, std::uint64_t width, size_t fileBytes)
+{
+	return offset % g_sectionAlignment == 0 && offset <= fileBytes && count <= (fileBytes - offset) / width;
+}
+
+static std::uint32_t snapshotCrc(const WishSnapshot::fileHeader &header, const WishSnapshot::bannerEntry* directory)
+{
+	std::uint32_t crc = crc32(&header, offsetof(WishSnapshot::fileHeader, crc));
+	return crc32(directory, sizeof(WishSnapshot::bannerEntry) * g_bannerCount, crc);
+}
+
+// Maps the file and checks header and directory, rows aren't read
+bool WishSnapshot::open(const std::string &path)
+{
+	close();
+	if (!m_file.open(path))
+	{
+		return false;
+	}
+
+	const std::byte* data = m_file.data();
+	size_t size = m_file.size();
+	auto fail = [&](const char* reason) {
+		std::cout << "error: " << path << ": " << reason << std::endl;
+		m_file.close();
+		return false;
+	};
+	if (size < sizeof(fileHeader) + sizeof(bannerEntry) * g_bannerCount)
+	{
+		return fail("not a wish snapshot");
+	}
+
+	// mapping starts at page boundary and sections are aligned, so they are read in place
+	const fileHeader* header = reinterpret_cast<const fileHeader*>(data);
+	const bannerEntry* directory = reinterpret_cast<const bannerEntry*>(data + sizeof(fileHeader));
+	if (std::memcmp(header->magic, g_snapshotMagic, sizeof(header->magic)) != 0)
+	{
+		return fail("not a wish snapshot");
+	}
+	if (header->version != g_snapshotVersion)
+	{
+		return fail("unsupported snapshot version");
+	}
+	if (header->fileBytes != size || header->blockRows == 0 || header->crc != snapshotCrc(*header, directory))
+	{
+		return fail("snapshot is damaged");
+	}
+
+	for (size_t i = 0; i < g_bannerCount; i++)
+	{
+		const bannerEntry &banner = directory[i];
+		if (!sectionFits(banner.timeOffset, banner.rows, sizeof(std::int64_t), size)
+			|| !sectionFits(banner.itemOffset, banner.rows, sizeof(std::uint32_t), size)
+			|| !sectionFits(banner.rarityOffset, banner.rows, sizeof(std::uint8_t), size)
+			|| !sectionFits(banner.typeOffset, banner.rows, sizeof(std::uint8_t), size)
+			|| !sectionFits(banner.blockOffset, banner.blockCount, sizeof(timeBlock), size)
+			|| banner.blockCount != (banner.rows + header->blockRows - 1) / header->blockRows)
+		{
+			return fail("snapshot is damaged");
+		}
+	}
+
+	// string table is small (one entry per item), every offset is checked so itemName can trust them
+	if (!sectionFits(header->stringOffset, static_cast<std::uint64_t>(header->stringCount) + 1, sizeof(std::uint32_t), size))
+	{
+		return fail("snapshot is damaged");
+	}
+	const std::uint32_t* offsets = reinterpret_cast<const std::uint32_t*>(data + header->stringOffset);
+	std::uint64_t stringsStart = header->stringOffset + (static_cast<std::uint64_t>(header->stringCount) + 1) * sizeof(std::uint32_t);
+	if (offsets[0] != 0 || offsets[header->stringCount] > size - stringsStart)
+	{
+		return fail("snapshot is damaged");
+	}
+	for (std::uint32_t i = 0; i < header->stringCount; i++)
+	{
+		if (offsets[i] > offsets[i + 1])
+		{
+			return fail("snapshot is damaged");
+		}
+	}
+
+	m_header = header;
+	m_directory = directory;
+	m_stringOffsets = offsets;
+	m_strings = reinterpret_cast<const char*>(data + stringsStart);
+	return true;
+}
+
+void WishSnapshot::close()
+{
+	m_file.close();
+	m_header = nullptr;
+	m_directory = nullptr;
+	m_stringOffsets = nullptr;
+	m_strings = nullptr;
+}
+
+const WishSnapshot::bannerEntry& WishSnapshot::entry(Banner banner) const
+{
+	return m_directory[static_cast<size_t>(banner)];
+}
+
+template <typename T>
+std::span<const T> WishSnapshot::column(std::uint64_t offset, std::uint64_t count) const
+{
+	return std::span<const T>(reinterpret_cast<const T*>(m_file.data() + offset), static_cast<size_t>(count));
+}
+
+size_t WishSnapshot::rows(Banner banner) const
+{
+	return isOpen() ? static_cast<size_t>(entry(banner).rows) : 0;
+}
+
+bool WishSnapshot::timeOrdered(Banner banner) const
+{
+	return isOpen() && entry(banner).timeOrdered != 0;
+}
+
+std::span<const std::int64_t> WishSnapshot::times(Banner banner) const
+{
+	return isOpen() ? column<std::int64_t>(entry(banner).timeOffset, entry(banner).rows) : std::span<const std::int64_t>();
+}
+
+std::span<const std::uint32_t> WishSnapshot::items(Banner banner) const
+{
+	return isOpen() ? column<std::uint32_t>(entry(banner).itemOffset, entry(banner).rows) : std::span<const std::uint32_t>();
+}
+
+std::span<const std::uint8_t> WishSnapshot::rarities(Banner banner) const
+{
+	return isOpen() ? column<std::uint8_t>(entry(banner).rarityOffset, entry(banner).rows) : std::span<const std::uint8_t>();
+}
+
+std::span<const std::uint8_t> WishSnapshot::types(Banner banner) const
+{
+	return isOpen() ? column<std::uint8_t>(entry(banner).typeOffset, entry(banner).rows) : std::span<const std::uint8_t>();
+}
+
+std::span<const WishSnapshot::timeBlock> WishSnapshot::blocks(Banner banner) const
+{
+	return isOpen() ? column<timeBlock>(entry(banner).blockOffset, entry(banner).blockCount) : std::span<const timeBlock>();
+}
+
+std::string_view WishSnapshot::itemName(std::uint32_t item) const
+{
+	if (!isOpen() || item >= m_header->stringCount)
+	{
+		return std::string_view();
+	}
+	return std::string_view(m_strings + m_stringOffsets[item], m_stringOffsets[item + 1] - m_stringOffsets[item]);
+}
+
+size_t WishSnapshot::itemCount() const
+{
+	return isOpen() ? m_header->stringCount : 0;
+}
+
+wishEntry WishSnapshot::row(Banner banner, size_t index) const
+{
+	return wishEntry(itemTypeToString(static_cast<wishItemType>(types(banner)[index])), std::string(itemName(items(banner)[index])),
+		epochToDate(times(banner)[index]), rarities(banner)[index]);
+}
+
+// Only blocks that are partly inside the range are scanned
+size_t WishSnapshot::countInRange(Banner banner, long long from, long long to) const
+{
+	std::span<const std::int64_t> time = times(banner);
+	std::span<const timeBlock> summary = blocks(banner);
+	size_t count = 0;
+	for (size_t i = 0; i < summary.size(); i++)
+	{
+		const timeBlock &block = summary[i];
+		if (block.maxTime < from || block.minTime > to)
+		{
+			continue;
+		}
+		size_t first = i * m_header->blockRows;
+		size_t last = std::min<size_t>(first + m_header->blockRows, time.size());
+		if (block.minTime >= from && block.maxTime <= to)
+		{
+			count += last - first;
+			continue;
+		}
+		for (size_t row = first; row < last; row++)
+		{
+			if (time[row] >= from && time[row] <= to)
+			{
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+std::pair<size_t, size_t> WishSnapshot::rowsInRange(Banner banner, long long from, long long to) const
+{
+	std::span<const std::int64_t> time = times(banner);
+	if (!timeOrdered(banner) || from > to)
+	{
+		return { 0, 0 };
+	}
+	auto first = std::lower_bound(time.begin(), time.end(), from);
+	auto last = std::upper_bound(first, time.end(), to);
+	return { static_cast<size_t>(first - time.begin()), static_cast<size_t>(last - time.begin()) };
+}
+
+// Pads file with zeros up to offset of the next section
+static bool padTo(AppendFile &out, std::uint64_t offset)
+{
+	static const char zeros[g_sectionAlignment] = {};
+	while (out.size() < offset)
+	{
+		if (!out.append(zeros, std::min<size_t>(sizeof(zeros), static_cast<size_t>(offset - out.size()))))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Reads every banner, lays out the file and writes sections in order
+bool writeSnapshot(const std::string &path, Database &db)
+{
+	using header_t = WishSnapshot::fileHeader;
+	using entry_t = WishSnapshot::bannerEntry;
+
+	std::array<std::vector<compactWish>, g_bannerCount> wishes;
+	std::array<std::vector<std::uint32_t>, g_bannerCount> itemColumns;
+	std::array<std::vector<WishSnapshot::timeBlock>, g_bannerCount> blockColumns;
+	// interned id -> position in string table, names are stored in order of first use
+	std::unordered_map<std::uint32_t, std::uint32_t> positions;
+	std::vector<std::uint32_t> names;
+	for (Banner banner : g_banners)
+	{
+		size_t b = static_cast<size_t>(banner);
+		db.getWishes(banner, wishes[b]);
+		itemColumns[b].reserve(wishes[b].size());
+		for (size_t i = 0; i < wishes[b].size(); i++)
+		{
+			const compactWish &wish = wishes[b][i];
+			auto [it, added] = positions.try_emplace(wish.itemId, static_cast<std::uint32_t>(names.size()));
+			if (added)
+			{
+				names.push_back(wish.itemId);
+			}
+			itemColumns[b].push_back(it->second);
+
+			if (i % WishSnapshot::blockRows == 0)
+			{
+				blockColumns[b].push_back(WishSnapshot::timeBlock{ wish.time, wish.time });
+			}
+			WishSnapshot::timeBlock &block = blockColumns[b].back();
+			block.minTime = std::min<std::int64_t>(block.minTime, wish.time);
+			block.maxTime = std::max<std::int64_t>(block.maxTime, wish.time);
+		}
+	}
+
+	StringInterner &interner = StringInterner::getInstance();
+	std::vector<std::uint32_t> stringOffsets{ 0 };
+	for (std::uint32_t id : names)
+	{
+		stringOffsets.push_back(stringOffsets.back() + static_cast<std::uint32_t>(interner.name(id).size()));
+	}
+
+	header_t header{};
+	std::memcpy(header.magic, g_snapshotMagic, sizeof(header.magic));
+	header.version = g_snapshotVersion;
+	header.blockRows = WishSnapshot::blockRows;
+	header.stringCount = static_cast<std::uint32_t>(names.size());
+	std::array<entry_t, g_bannerCount> directory{};
+	std::uint64_t offset = alignSection(sizeof(header) + sizeof(directory));
+	for (size_t b = 0; b < g_bannerCount; b++)
+	{
+		entry_t &entry = directory[b];
+		auto &rows = wishes[b];
+		entry.rows = rows.size();
+		entry.timeOrdered = std::is_sorted(rows.begin(), rows.end(), [](const compactWish &x, const compactWish &y) { return x.time < y.time; });
+		entry.timeOffset = offset;
+		entry.itemOffset = alignSection(entry.timeOffset + entry.rows * sizeof(std::int64_t));
+		entry.rarityOffset = alignSection(entry.itemOffset + entry.rows * sizeof(std::uint32_t));
+		entry.typeOffset = alignSection(entry.rarityOffset + entry.rows);
+		entry.blockOffset = alignSection(entry.typeOffset + entry.rows);
+		entry.blockCount = blockColumns[b].size();
+		offset = alignSection(entry.blockOffset + entry.blockCount * sizeof(WishSnapshot::timeBlock));
+	}
+	header.stringOffset = offset;
+	header.fileBytes = offset + stringOffsets.size() * sizeof(std::uint32_t) + stringOffsets.back();
+	header.crc = snapshotCrc(header, directory.data());
+
+	// written to a temporary file first, so snapshot at path is always complete
+	std::string tmpPath = path + ".tmp";
+	std::error_code error;
+	std::filesystem::remove(tmpPath, error);
+	AppendFile out;
+	bool written = out.open(tmpPath) && out.append(&header, sizeof(header)) && out.append(directory.data(), sizeof(directory));
+	std::vector<std::int64_t> times;
+	std::vector<std::uint8_t> bytes;
+	for (size_t b = 0; b < g_bannerCount && written; b++)
+	{
+		const entry_t &entry = directory[b];
+		auto &rows = wishes[b];
+		times.clear();
+		for (auto &wish : rows)
+		{
+			times.push_back(wish.time);
+		}
+		written = padTo(out, entry.timeOffset) && out.append(times.data(), times.size() * sizeof(std::int64_t))
+			&& padTo(out, entry.itemOffset) && out.append(itemColumns[b].data(), itemColumns[b].size() * sizeof(std::uint32_t));
+
+		bytes.clear();
+		for (auto &wish : rows)
+		{
+			bytes.push_back(wish.itemRarity);
+		}
+		written = written && padTo(out, entry.rarityOffset) && out.append(bytes.data(), bytes.size());
+
+		bytes.clear();
+		for (auto &wish : rows)
+		{
+			bytes.push_back(static_cast<std::uint8_t>(wish.itemType));
+		}
+		written = written && padTo(out, entry.typeOffset) && out.append(bytes.data(), bytes.size())
+			&& padTo(out, entry.blockOffset) && out.append(blockColumns[b].data(), blockColumns[b].size() * sizeof(WishSnapshot::timeBlock));
+	}
+	written = written && padTo(out, header.stringOffset) && out.append(stringOffsets.data(), stringOffsets.size() * sizeof(std::uint32_t));
+	for (size_t i = 0; i < names.size() && written; i++)
+	{
+		const std::string &name = interner.name(names[i]);
+		written = out.append(name.data(), name.size());
+	}
+	written = written && out.size() == header.fileBytes && out.sync();
+	out.close();
+
+	if (written)
+	{
+		std::filesystem::rename(tmpPath, path, error);
+		if (!error)
+		{
+			return true;
+		}
+		std::cout << "error: can't replace " << path << ": " << error.message() << std::endl;
+	}
+	std::filesystem::remove(tmpPath, error);
+	return false;
+}
@@ -0,0 +1,102 @@
+#ifndef WISH_SNAPSHOT_H
+#define WISH_SNAPSHOT_H
+
+#include "db.h"
+#include "mappedFile.h"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*
+Read-only columnar snapshot of the whole history (.gwv), so viewer doesn't reopen sqlite and parse rows on every start.
+
+	writeSnapshot exports every banner of any Database into one file, WishSnapshot maps it and hands out spans into the mapping,
+	opening reads only header and directory (checked by crc32), rows stay in page cache and are never copied to heap
+	layout, native byte order, every section 8 byte aligned:
+		header, directory (one entry per banner), per banner: time, item, rarity and type columns and its blocks,
+		string table (offsets of item names, then their bytes)
+	item column holds positions in string table, so the file doesn't depend on ids of StringInterner
+	block is summary of blockRows consecutive rows (min/max time), range queries skip blocks outside the range
+	rows are in getWishes order of the exported db, timeOrdered flag tells if times never decrease
+	file is written next to the target and renamed over it, so reader never maps half written snapshot
+	Windows can't replace a mapped file, close WishSnapshot before exporting to the same path again
+*/
+
+class WishSnapshot
+{
+public:
+	static constexpr std::uint32_t blockRows = 1024;
+
+	// On disk format
+	struct fileHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t blockRows;
+		std::uint32_t stringCount;
+		std::uint64_t stringOffset;
+		std::uint64_t fileBytes;
+		// crc32 of header fields above and of the directory
+		std::uint32_t crc;
+		std::uint32_t reserved;
+	};
+	struct bannerEntry
+	{
+		std::uint64_t rows;
+		std::uint64_t timeOffset;
+		std::uint64_t itemOffset;
+		std::uint64_t rarityOffset;
+		std::uint64_t typeOffset;
+		std::uint64_t blockOffset;
+		std::uint64_t blockCount;
+		std::uint64_t timeOrdered;
+	};
+	struct timeBlock
+	{
+		std::int64_t minTime;
+		std::int64_t maxTime;
+	};
+
+	// Example usecase:		WishSnapshot snapshot; if (snapshot.open("history.gwv")) { auto times = snapshot.times(Banner::Character); }
+	bool open(const std::string &path);
+	void close();
+	bool isOpen() const { return m_header != nullptr; }
+
+	// Spans point into the mapping, they are valid until close
+	size_t rows(Banner banner) const;
+	bool timeOrdered(Banner banner) const;
+	std::span<const std::int64_t> times(Banner banner) const;
+	std::span<const std::uint32_t> items(Banner banner) const;
+	std::span<const std::uint8_t> rarities(Banner banner) const;
+	std::span<const std::uint8_t> types(Banner banner) const;
+	std::span<const timeBlock> blocks(Banner banner) const;
+
+	// Item name at position in string table (value of items()), empty for position that isn't there
+	std::string_view itemName(std::uint32_t item) const;
+	size_t itemCount() const;
+	wishEntry row(Banner banner, size_t index) const;
+
+	// Wishes received between from and to (both inclusive), blocks inside the range are counted without reading rows
+	size_t countInRange(Banner banner, long long from, long long to) const;
+	// Rows [first, last) received between from and to, needs timeOrdered
+	std::pair<size_t, size_t> rowsInRange(Banner banner, long long from, long long to) const;
+
+private:
+	template <typename T>
+	std::span<const T> column(std::uint64_t offset, std::uint64_t count) const;
+	const bannerEntry& entry(Banner banner) const;
+
+	MappedFile m_file;
+	const fileHeader* m_header = nullptr;
+	const bannerEntry* m_directory = nullptr;
+	const std::uint32_t* m_stringOffsets = nullptr;
+	const char* m_strings = nullptr;
+};
+
+// Exports every banner of db into snapshot file at path
+// Example usecase:		writeSnapshot("history.gwv", db);
+bool writeSnapshot(const std::string &path, Database &db);
+
+#endif /* WISH_SNAPSHOT_H */
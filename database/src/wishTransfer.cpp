@@ -0,0 +1,901 @@
+#include "wishTransfer.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+constexpr std::array<const char*, g_bannerCount> g_bannerNames = { "Character", "Weapon", "Standard", "Beginner" };
+constexpr std::string_view g_csvHeader = "banner,time,itemType,itemName,rarity\n";
+
+static bool bannerFromName(std::string_view name, Banner &banner)
+{
+	for (size_t i = 0; i < g_bannerCount; i++)
+	{
+		if (name == g_bannerNames[i])
+		{
+			banner = g_banners[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+// Collects output in one chunk and writes it with a single fwrite when it's full
+class chunkWriter
+{
+public:
+	chunkWriter(std::FILE* file) : m_file(file), m_buffer(g_transferChunkBytes) {}
+
+	void append(std::string_view text)
+	{
+		if (text.size() > m_buffer.size() - m_used)
+		{
+			flush();
+			if (text.size() > m_buffer.size())
+			{
+				write(text.data(), text.size());
+				return;
+			}
+		}
+		std::memcpy(m_buffer.data() + m_used, text.data(), text.size());
+		m_used += text.size();
+	}
+
+	void append(char c)
+	{
+		if (m_used == m_buffer.size())
+		{
+			flush();
+		}
+		m_buffer[m_used++] = c;
+	}
+
+	void appendNumber(long long value)
+	{
+		char digits[24];
+		auto result = std::to_chars(digits, digits + sizeof(digits), value);
+		append(std::string_view(digits, result.ptr - digits));
+	}
+
+	bool flush()
+	{
+		write(m_buffer.data(), m_used);
+		m_used = 0;
+		return !m_failed;
+	}
+
+	size_t written() const { return m_written; }
+
+private:
+	void write(const char* data, size_t bytes)
+	{
+		if (bytes > 0 && !m_failed && std::fwrite(data, 1, bytes, m_file) != bytes)
+		{
+			m_failed = true;
+		}
+		m_written += bytes;
+	}
+
+	std::FILE* m_file;
+	std::vector<char> m_buffer;
+	size_t m_used = 0;
+	size_t m_written = 0;
+	bool m_failed = false;
+};
+
+// Quoted only if it has to be, quotes inside are doubled
+static void appendCsvField(chunkWriter &out, std::string_view field)
+{
+	if (field.find_first_of(",\"\r\n") == std::string_view::npos)
+	{
+		out.append(field);
+		return;
+	}
+	out.append('"');
+	for (char c : field)
+	{
+		if (c == '"')
+		{
+			out.append('"');
+		}
+		out.append(c);
+	}
+	out.append('"');
+}
+
+// UTF-8 is written as it is, only quote, backslash and control characters are escaped
+static void appendJsonString(chunkWriter &out, std::string_view text)
+{
+	out.append('"');
+	size_t start = 0;
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		unsigned char c = static_cast<unsigned char>(text[i]);
+		if (c >= 0x20 && c != '"' && c != '\\')
+		{
+			continue;
+		}
+		out.append(text.substr(start, i - start));
+		switch (c)
+		{
+		case '"': out.append("\\\""); break;
+		case '\\': out.append("\\\\"); break;
+		case '\n': out.append("\\n"); break;
+		case '\r': out.append("\\r"); break;
+		case '\t': out.append("\\t"); break;
+		default:
+		{
+			char escaped[8];
+			std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out.append(escaped);
+		}
+		}
+		start = i + 1;
+	}
+	out.append(text.substr(start));
+	out.append('"');
+}
+
+// Writes banners one after another, rows of a banner in forEachWish order
+bool exportHistory(Database &db, const std::string &path, transferFormat format, transferStats* stats)
+{
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		std::cout << "error: can't open " << path << " for writing" << std::endl;
+		return false;
+	}
+	// chunkWriter is the buffer, stdio would only copy every chunk once more
+	std::setvbuf(file, nullptr, _IONBF, 0);
+
+	chunkWriter out(file);
+	size_t rows = 0;
+	if (format == transferFormat::Csv)
+	{
+		out.append(g_csvHeader);
+	}
+	for (size_t b = 0; b < g_bannerCount; b++)
+	{
+		std::string_view bannerName = g_bannerNames[b];
+		db.forEachWish(g_banners[b], [&](const wishEntry &wish) {
+			if (format == transferFormat::Csv)
+			{
+				out.append(bannerName);
+				out.append(',');
+				appendCsvField(out, wish.date);
+				out.append(',');
+				appendCsvField(out, wish.itemType);
+				out.append(',');
+				appendCsvField(out, wish.itemName);
+				out.append(',');
+				out.appendNumber(wish.itemRarity);
+				out.append('\n');
+			}
+			else
+			{
+				out.append("{\"banner\":\"");
+				out.append(bannerName);
+				out.append("\",\"time\":");
+				appendJsonString(out, wish.date);
+				out.append(",\"itemType\":");
+				appendJsonString(out, wish.itemType);
+				out.append(",\"itemName\":");
+				appendJsonString(out, wish.itemName);
+				out.append(",\"rarity\":");
+				out.appendNumber(wish.itemRarity);
+				out.append("}\n");
+			}
+			rows++;
+		});
+	}
+
+	bool written = out.flush();
+	written = std::fclose(file) == 0 && written;
+	if (!written)
+	{
+		std::cout << "error: can't write " << path << std::endl;
+	}
+	if (stats)
+	{
+		stats->rows = rows;
+		stats->bytes = out.written();
+	}
+	return written;
+}
+
+// Fields of one record, views point into the read buffer or into scratch strings of the parser
+struct recordFields
+{
+	std::string_view banner;
+	std::string_view time;
+	std::string_view itemType;
+	std::string_view itemName;
+	std::string_view rarity;
+	// JSON number instead of date string
+	long long epoch = -1;
+	long long rarityNumber = -1;
+};
+
+enum recordField : size_t
+{
+	BannerField,
+	TimeField,
+	ItemTypeField,
+	ItemNameField,
+	RarityField,
+	FieldCount
+};
+constexpr std::array<std::string_view, FieldCount> g_fieldNames = { "banner", "time", "itemType", "itemName", "rarity" };
+
+static std::string_view& fieldOf(recordFields &record, size_t field)
+{
+	switch (field)
+	{
+	case BannerField: return record.banner;
+	case TimeField: return record.time;
+	case ItemTypeField: return record.itemType;
+	case ItemNameField: return record.itemName;
+	default: return record.rarity;
+	}
+}
+
+// Position of '\n' that ends CSV record starting at start, npos if the record isn't complete in data[start, end)
+// newline inside quoted field doesn't end the record, it's inside when odd number of quotes precede it
+static size_t csvRecordEnd(const char* data, size_t start, size_t end)
+{
+	size_t quotes = 0;
+	size_t scan = start;
+	while (true)
+	{
+		const void* found = std::memchr(data + scan, '\n', end - scan);
+		if (!found)
+		{
+			return std::string_view::npos;
+		}
+		size_t newline = static_cast<const char*>(found) - data;
+		for (const char* quote = data + scan; (quote = static_cast<const char*>(std::memchr(quote, '"', data + newline - quote))); quote++)
+		{
+			quotes++;
+		}
+		if (quotes % 2 == 0)
+		{
+			return newline;
+		}
+		scan = newline + 1;
+	}
+}
+
+// Splits record into fields, quoted fields are unescaped into scratch (deque, so views into it stay valid)
+static bool splitCsv(std::string_view record, std::vector<std::string_view> &fields, std::deque<std::string> &scratch)
+{
+	fields.clear();
+	size_t quoted = 0;
+	size_t pos = 0;
+	while (true)
+	{
+		if (pos < record.size() && record[pos] == '"')
+		{
+			if (quoted == scratch.size())
+			{
+				scratch.emplace_back();
+			}
+			std::string &text = scratch[quoted++];
+			text.clear();
+			pos++;
+			while (true)
+			{
+				size_t quote = record.find('"', pos);
+				if (quote == std::string_view::npos)
+				{
+					return false;
+				}
+				text.append(record.data() + pos, quote - pos);
+				if (quote + 1 < record.size() && record[quote + 1] == '"')
+				{
+					text += '"';
+					pos = quote + 2;
+					continue;
+				}
+				pos = quote + 1;
+				break;
+			}
+			fields.push_back(text);
+			if (pos == record.size())
+			{
+				return true;
+			}
+			if (record[pos] != ',')
+			{
+				return false;
+			}
+			pos++;
+		}
+		else
+		{
+			size_t comma = record.find(',', pos);
+			if (comma == std::string_view::npos)
+			{
+				fields.push_back(record.substr(pos));
+				return true;
+			}
+			fields.push_back(record.substr(pos, comma - pos));
+			pos = comma + 1;
+		}
+	}
+}
+
+static void appendUtf8(std::string &text, std::uint32_t code)
+{
+	if (code < 0x80)
+	{
+		text += static_cast<char>(code);
+	}
+	else if (code < 0x800)
+	{
+		text += static_cast<char>(0xC0 | (code >> 6));
+		text += static_cast<char>(0x80 | (code & 0x3F));
+	}
+	else if (code < 0x10000)
+	{
+		text += static_cast<char>(0xE0 | (code >> 12));
+		text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+		text += static_cast<char>(0x80 | (code & 0x3F));
+	}
+	else
+	{
+		text += static_cast<char>(0xF0 | (code >> 18));
+		text += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+		text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+		text += static_cast<char>(0x80 | (code & 0x3F));
+	}
+}
+
+// Hand written parser for one JSON object of flat values, which is all JSON lines of wishes need
+class jsonRecordParser
+{
+public:
+	jsonRecordParser(std::string_view text) : m_text(text) {}
+
+	bool parse(recordFields &record, std::array<std::string, FieldCount + 1> &scratch)
+	{
+		skipSpace();
+		if (!consume('{'))
+		{
+			return false;
+		}
+		skipSpace();
+		if (consume('}'))
+		{
+			return atEnd();
+		}
+		while (true)
+		{
+			std::string_view key;
+			skipSpace();
+			if (!string(key, scratch[FieldCount]))
+			{
+				return false;
+			}
+			size_t field = std::find(g_fieldNames.begin(), g_fieldNames.end(), key) - g_fieldNames.begin();
+			skipSpace();
+			if (!consume(':'))
+			{
+				return false;
+			}
+			skipSpace();
+
+			if (peek() == '"')
+			{
+				std::string_view value;
+				if (!string(value, scratch[std::min<size_t>(field, FieldCount)]))
+				{
+					return false;
+				}
+				if (field < FieldCount)
+				{
+					fieldOf(record, field) = value;
+				}
+			}
+			else if (peek() == '-' || (peek() >= '0' && peek() <= '9'))
+			{
+				long long value;
+				if (!number(value))
+				{
+					return false;
+				}
+				if (field == TimeField)
+				{
+					record.epoch = value;
+				}
+				else if (field == RarityField)
+				{
+					record.rarityNumber = value;
+				}
+			}
+			else if (!literal("true") && !literal("false") && !literal("null"))
+			{
+				// nested objects and arrays aren't part of the format
+				return false;
+			}
+
+			skipSpace();
+			if (consume('}'))
+			{
+				return atEnd();
+			}
+			if (!consume(','))
+			{
+				return false;
+			}
+		}
+	}
+
+private:
+	char peek() const { return m_pos < m_text.size() ? m_text[m_pos] : '\0'; }
+
+	bool consume(char c)
+	{
+		if (peek() != c)
+		{
+			return false;
+		}
+		m_pos++;
+		return true;
+	}
+
+	void skipSpace()
+	{
+		while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\r'))
+		{
+			m_pos++;
+		}
+	}
+
+	bool atEnd()
+	{
+		skipSpace();
+		return m_pos == m_text.size();
+	}
+
+	bool literal(std::string_view word)
+	{
+		if (m_text.substr(m_pos, word.size()) != word)
+		{
+			return false;
+		}
+		m_pos += word.size();
+		return true;
+	}
+
+	// Integer part is the value, fraction and exponent are skipped (wish fields are integers)
+	bool number(long long &value)
+	{
+		auto result = std::from_chars(m_text.data() + m_pos, m_text.data() + m_text.size(), value);
+		if (result.ec != std::errc())
+		{
+			return false;
+		}
+		m_pos = result.ptr - m_text.data();
+		while (m_pos < m_text.size() && std::string_view("0123456789.eE+-").find(m_text[m_pos]) != std::string_view::npos)
+		{
+			m_pos++;
+		}
+		return true;
+	}
+
+	bool hex4(size_t at, std::uint32_t &code) const
+	{
+		if (at + 4 > m_text.size())
+		{
+			return false;
+		}
+		auto result = std::from_chars(m_text.data() + at, m_text.data() + at + 4, code, 16);
+		return result.ec == std::errc() && result.ptr == m_text.data() + at + 4;
+	}
+
+	// String without escapes is returned as view into the record, escaped one is decoded into scratch
+	bool string(std::string_view &value, std::string &scratch)
+	{
+		if (!consume('"'))
+		{
+			return false;
+		}
+		// plain loop, find_first_of would call memchr on the two stop characters for every character of the string
+		size_t start = m_pos;
+		size_t stop = start;
+		while (stop < m_text.size() && m_text[stop] != '"' && m_text[stop] != '\\')
+		{
+			stop++;
+		}
+		if (stop == m_text.size())
+		{
+			return false;
+		}
+		if (m_text[stop] == '"')
+		{
+			value = m_text.substr(start, stop - start);
+			m_pos = stop + 1;
+			return true;
+		}
+
+		scratch.assign(m_text.data() + start, stop - start);
+		m_pos = stop;
+		while (m_pos < m_text.size())
+		{
+			char c = m_text[m_pos++];
+			if (c == '"')
+			{
+				value = scratch;
+				return true;
+			}
+			if (c != '\\')
+			{
+				scratch += c;
+				continue;
+			}
+			if (m_pos >= m_text.size())
+			{
+				return false;
+			}
+			char escape = m_text[m_pos++];
+			switch (escape)
+			{
+			case '"': case '\\': case '/': scratch += escape; break;
+			case 'b': scratch += '\b'; break;
+			case 'f': scratch += '\f'; break;
+			case 'n': scratch += '\n'; break;
+			case 'r': scratch += '\r'; break;
+			case 't': scratch += '\t'; break;
+			case 'u':
+			{
+				std::uint32_t code;
+				if (!hex4(m_pos, code))
+				{
+					return false;
+				}
+				m_pos += 4;
+				if (code >= 0xD800 && code < 0xDC00)
+				{
+					// character outside BMP comes as surrogate pair
+					std::uint32_t low;
+					if (m_text.substr(m_pos, 2) != "\\u" || !hex4(m_pos + 2, low) || low < 0xDC00 || low >= 0xE000)
+					{
+						return false;
+					}
+					m_pos += 6;
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				}
+				appendUtf8(scratch, code);
+				break;
+			}
+			default:
+				return false;
+			}
+		}
+		return false;
+	}
+
+	std::string_view m_text;
+	size_t m_pos = 0;
+};
+
+// Parsed records go into per banner batches, full batch is written when the next wish has a different time
+class historyImporter
+{
+public:
+	historyImporter(Database &db, const std::string &path, bool idempotent) : m_db(db), m_path(path), m_idempotent(idempotent)
+	{
+		for (auto &batch : m_batches)
+		{
+			batch.reserve(g_transferBatchRows);
+		}
+	}
+
+	// Returns false if the record is rejected
+	bool add(const recordFields &record)
+	{
+		Banner banner;
+		if (!bannerFromName(record.banner, banner))
+		{
+			return reject("unknown banner");
+		}
+
+		long long time = record.epoch;
+		if (!record.time.empty())
+		{
+			time = dateToEpoch(record.time);
+			if (time < 0 && std::all_of(record.time.begin(), record.time.end(), [](char c) { return c >= '0' && c <= '9'; }))
+			{
+				std::from_chars(record.time.data(), record.time.data() + record.time.size(), time);
+			}
+		}
+		if (time < 0)
+		{
+			return reject("invalid time");
+		}
+
+		long long rarity = record.rarityNumber;
+		if (!record.rarity.empty())
+		{
+			auto result = std::from_chars(record.rarity.data(), record.rarity.data() + record.rarity.size(), rarity);
+			if (result.ec != std::errc() || result.ptr != record.rarity.data() + record.rarity.size())
+			{
+				rarity = -1;
+			}
+		}
+		if (rarity < 0 || rarity > 255)
+		{
+			return reject("invalid rarity");
+		}
+		if (record.itemName.empty())
+		{
+			return reject("missing item name");
+		}
+
+		compactWish wish{ time, StringInterner::getInstance().intern(record.itemName), itemTypeFromString(record.itemType),
+			static_cast<std::uint8_t>(rarity) };
+		std::vector<compactWish> &batch = m_batches[static_cast<size_t>(banner)];
+		if (batch.size() >= g_transferBatchRows && batch.back().time != wish.time && !flush(banner))
+		{
+			return false;
+		}
+		batch.push_back(wish);
+		m_stats.rows++;
+		return true;
+	}
+
+	bool reject(const char* reason)
+	{
+		if (m_stats.rejected++ == 0)
+		{
+			std::cout << "error: " << m_path << ":" << m_record << ": " << reason << ", skipping record" << std::endl;
+		}
+		return false;
+	}
+
+	// Returns false if the backend couldn't store the batch, nothing is written after that
+	bool flush(Banner banner)
+	{
+		std::vector<compactWish> &batch = m_batches[static_cast<size_t>(banner)];
+		if (m_failed || batch.empty())
+		{
+			return !m_failed;
+		}
+		if (m_idempotent)
+		{
+			// entries are reused, so their strings keep their capacity between batches
+			StringInterner &interner = StringInterner::getInstance();
+			for (size_t i = 0; i < batch.size(); i++)
+			{
+				if (i == m_entries.size())
+				{
+					m_entries.emplace_back("", "", "", 0);
+				}
+				wishEntry &entry = m_entries[i];
+				entry.itemType.assign(itemTypeToString(batch[i].itemType));
+				entry.itemName.assign(interner.name(batch[i].itemId));
+				epochToDate(batch[i].time, entry.date);
+				entry.itemRarity = batch[i].itemRarity;
+			}
+			m_stats.inserted += m_db.importWishes(banner, std::span<const wishEntry>(m_entries.data(), batch.size()));
+		}
+		else
+		{
+			size_t inserted;
+			if (!m_db.tryInsertWishes(banner, std::span<const compactWish>(batch), inserted))
+			{
+				std::cout << "error: " << m_path << ": wishes for " << bannerTableName(banner) << " were not stored" << std::endl;
+				m_failed = true;
+				return false;
+			}
+			m_stats.inserted += inserted;
+		}
+		batch.clear();
+		return true;
+	}
+
+	bool finish()
+	{
+		for (Banner banner : g_banners)
+		{
+			if (!flush(banner))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Record number is only used in error messages
+	void startRecord(size_t record) { m_record = record; }
+	const transferStats& stats() const { return m_stats; }
+	bool failed() const { return m_failed; }
+
+private:
+	Database &m_db;
+	const std::string &m_path;
+	const bool m_idempotent;
+	std::array<std::vector<compactWish>, g_bannerCount> m_batches;
+	std::vector<wishEntry> m_entries;
+	transferStats m_stats;
+	size_t m_record = 0;
+	bool m_failed = false;
+};
+
+// Reads chunks into one buffer, complete records are parsed in place and the incomplete tail is moved to the front
+bool importHistory(Database &db, const std::string &path, transferFormat format, bool idempotent, transferStats* stats)
+{
+	std::FILE* file = std::fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		std::cout << "error: can't open " << path << std::endl;
+		return false;
+	}
+	std::setvbuf(file, nullptr, _IONBF, 0);
+
+	historyImporter importer(db, path, idempotent);
+	std::vector<char> buffer(g_transferChunkBytes);
+	size_t start = 0;
+	size_t end = 0;
+	size_t bytes = 0;
+	bool eof = false;
+	bool ok = true;
+	bool skipLine = false;
+	size_t records = 0;
+
+	// CSV columns by position, found in header
+	bool csv = format == transferFormat::Csv;
+	bool header = csv;
+	std::array<size_t, FieldCount> columns{};
+	std::vector<std::string_view> fields;
+	std::deque<std::string> csvScratch;
+	std::array<std::string, FieldCount + 1> jsonScratch;
+
+	while (ok && !eof)
+	{
+		if (start > 0)
+		{
+			std::memmove(buffer.data(), buffer.data() + start, end - start);
+			end -= start;
+			start = 0;
+		}
+		if (end == buffer.size() && buffer.size() >= g_transferMaxRecordBytes)
+		{
+			// unmatched quote turns the rest of the file into one record, it's rejected and parsing continues on the next line
+			importer.startRecord(++records);
+			importer.reject("record too long");
+			const void* newline = std::memchr(buffer.data(), '\n', end);
+			start = newline ? static_cast<const char*>(newline) - buffer.data() + 1 : end;
+			skipLine = !newline;
+			continue;
+		}
+		if (end == buffer.size())
+		{
+			// record longer than the buffer
+			buffer.resize(buffer.size() * 2);
+		}
+		size_t read = std::fread(buffer.data() + end, 1, buffer.size() - end, file);
+		if (read == 0)
+		{
+			if (std::ferror(file))
+			{
+				std::cout << "error: can't read " << path << std::endl;
+				ok = false;
+				break;
+			}
+			eof = true;
+		}
+		end += read;
+		bytes += read;
+		if (skipLine)
+		{
+			// rest of the line of a rejected record, up to its newline
+			const void* newline = std::memchr(buffer.data(), '\n', end);
+			start = newline ? static_cast<const char*>(newline) - buffer.data() + 1 : end;
+			skipLine = !newline;
+		}
+
+		while (start < end)
+		{
+			size_t recordEnd = csv ? csvRecordEnd(buffer.data(), start, end) : std::string_view::npos;
+			if (!csv)
+			{
+				// newline can't be inside JSON string, it's escaped there
+				const void* newline = std::memchr(buffer.data() + start, '\n', end - start);
+				recordEnd = newline ? static_cast<const char*>(newline) - buffer.data() : std::string_view::npos;
+			}
+			if (recordEnd == std::string_view::npos)
+			{
+				if (!eof)
+				{
+					break;
+				}
+				// last record without newline
+				recordEnd = end;
+			}
+
+			std::string_view record(buffer.data() + start, recordEnd - start);
+			start = std::min(recordEnd + 1, end);
+			importer.startRecord(++records);
+			if (!record.empty() && record.back() == '\r')
+			{
+				record.remove_suffix(1);
+			}
+			if (records == 1 && record.starts_with("\xEF\xBB\xBF"))
+			{
+				// byte order mark written by spreadsheet programs
+				record.remove_prefix(3);
+			}
+			if (record.empty())
+			{
+				continue;
+			}
+
+			recordFields parsed;
+			if (header)
+			{
+				header = false;
+				splitCsv(record, fields, csvScratch);
+				for (size_t field = 0; field < FieldCount; field++)
+				{
+					columns[field] = std::find(fields.begin(), fields.end(), g_fieldNames[field]) - fields.begin();
+					if (columns[field] == fields.size())
+					{
+						std::cout << "error: " << path << ": missing column " << g_fieldNames[field] << std::endl;
+						ok = false;
+						break;
+					}
+				}
+				if (!ok)
+				{
+					break;
+				}
+				continue;
+			}
+			else if (csv)
+			{
+				if (!splitCsv(record, fields, csvScratch))
+				{
+					importer.reject("malformed record");
+					continue;
+				}
+				for (size_t field = 0; field < FieldCount; field++)
+				{
+					if (columns[field] < fields.size())
+					{
+						fieldOf(parsed, field) = fields[columns[field]];
+					}
+				}
+			}
+			else if (!jsonRecordParser(record).parse(parsed, jsonScratch))
+			{
+				importer.reject("malformed record");
+				continue;
+			}
+			importer.add(parsed);
+			if (importer.failed())
+			{
+				ok = false;
+				break;
+			}
+		}
+	}
+	std::fclose(file);
+
+	if (!importer.finish())
+	{
+		ok = false;
+	}
+	if (stats)
+	{
+		*stats = importer.stats();
+		stats->bytes = bytes;
+	}
+	return ok;
+}
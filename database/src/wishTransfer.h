@@ -0,0 +1,54 @@
+#ifndef WISH_TRANSFER_H
+#define WISH_TRANSFER_H
+
+#include "db.h"
+#include <string>
+
+/*
+Streaming export and import of the whole history as CSV or JSON lines, for moving data to and from other trackers.
+
+	CSV: header line banner,time,itemType,itemName,rarity, columns are found by name so their order doesn't matter,
+	fields with comma, quote or newline are quoted (RFC 4180)
+	JSON lines: one object per wish {"banner":"Character","time":"2021-01-12 18:37:29","itemType":"Weapon","itemName":"Slingshot","rarity":3},
+	keys in any order, unknown keys are ignored
+	time is "YYYY-MM-DD HH:MM:SS" like everywhere at the API level, import also takes epoch seconds (plain number)
+	export streams every banner through forEachWish into a 1 MiB buffer written with one fwrite per chunk,
+	import reads the file in 1 MiB chunks and parses records in place, nothing is converted to wishEntry on the way
+	(except for idempotent import, importWishes takes wishEntry), memory use doesn't depend on the size of the file
+	records are found with memchr (vectorized by the C library), parser is hand written, names are interned from the buffer
+	import writes batches of transferBatchRows wishes per banner, batch never splits wishes with the same time (10-pull),
+	so seq numbers and import dedupe work the same as with one big insert
+	rejected record (unknown banner, bad date, malformed line, longer than transferMaxRecordBytes) is counted and skipped,
+	first one is reported
+	import fails (returns false) if the backend couldn't store a batch, inserted counts what it stored until then
+*/
+
+enum class transferFormat
+{
+	Csv,
+	JsonLines
+};
+
+struct transferStats
+{
+	// wishes written to the file (export) or read from it (import)
+	size_t rows = 0;
+	// import: wishes that were new (idempotent import skips stored ones)
+	size_t inserted = 0;
+	// import: records that couldn't be parsed
+	size_t rejected = 0;
+	size_t bytes = 0;
+};
+
+constexpr size_t g_transferChunkBytes = 1 << 20;
+constexpr size_t g_transferBatchRows = 8192;
+// Buffer grows up to this for a long record, longer one is rejected
+constexpr size_t g_transferMaxRecordBytes = 4 * g_transferChunkBytes;
+
+// Example usecase:		exportHistory(db, "history.csv", transferFormat::Csv);
+bool exportHistory(Database &db, const std::string &path, transferFormat format, transferStats* stats = nullptr);
+// idempotent goes through importWishes, so the same file can be imported again without duplicating history
+// Example usecase:		importHistory(db, "history.jsonl", transferFormat::JsonLines, true);
+bool importHistory(Database &db, const std::string &path, transferFormat format, bool idempotent, transferStats* stats = nullptr);
+
+#endif /* WISH_TRANSFER_H */